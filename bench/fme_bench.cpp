@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "byte_scanner.h"
+#include "command_parser.h"
+#include "file_manager_emulator.h"
+#include "fs_node.h"
+#include "logger.h"
+#include "workload_generator.h"
+
+namespace
+{
+/**
+ * \brief Options of the command line: [--commands=N] [--repetitions=N] [--seed=N] [--generate=deep|wide|cpmv].
+ */
+struct Options
+{
+        std::size_t                 commandsNumber = 100000;
+        std::size_t                 repetitions    = 5;
+        std::uint32_t               seed           = 1;
+        std::optional<WorkloadKind> generate;  /// Only the batch is generated into standard output.
+};
+
+constexpr inline auto usage = " [--commands=N] [--repetitions=N] [--seed=N] [--generate=deep|wide|cpmv]";
+
+// The path, which is resolved by the path benchmarks, is the deepest directory of the deep workload
+constexpr inline auto resolvedDepth = std::size_t{32};
+
+/**
+ * \brief Logger, which formats the enabled messages and drops them, so logging costs only the formatting.
+ */
+class NullLogger final : public Logger
+{
+    public:
+        explicit NullLogger(const LogLevel minLevel) : Logger{minLevel} {}
+
+        void        flush() override {}
+
+        std::size_t loggedBytes() const noexcept
+        {
+            return m_loggedBytes;
+        }
+
+    protected:
+        bool finishLog() override
+        {
+            return true;
+        }
+
+        bool writeLog(const std::string_view log) override
+        {
+            m_loggedBytes += log.size();
+            return true;
+        }
+
+        bool writeLogChunk(const std::string_view chunk) override
+        {
+            m_loggedBytes += chunk.size();
+            return true;
+        }
+
+    private:
+        std::size_t m_loggedBytes = 0;
+};
+
+using Workloads = std::vector<std::pair<WorkloadKind, std::string>>;
+
+/**
+ * \brief The emulator with the tree built by the batch, the logger stays accessible.
+ */
+struct Emulator
+{
+        NullLogger*                          logger = nullptr;  /// Owned by fme.
+        std::unique_ptr<FileManagerEmulator> fme;
+};
+
+Emulator makeEmulator(const std::string_view batch, const LogLevel logLevel = LogLevel::Off)
+{
+    auto logger = std::make_unique<NullLogger>(LogLevel::Off);
+    auto result = Emulator{.logger = logger.get(), .fme = std::make_unique<FileManagerEmulator>(std::move(logger))};
+    if (!batch.empty() && result.fme->runCommands(batch) != ErrorCode::NoError)
+    {
+        std::cerr << "The benchmark batch failed" << std::endl;
+    }
+    result.logger->setMinLevel(logLevel);
+    return result;
+}
+
+/**
+ * \brief Runs the benchmark several times and prints the best time per operation.
+ *
+ * \param run Executes the measured operations and returns their number.
+ * \param prepare Prepares the state of the next repetition, it isn't measured.
+ */
+void measure(const std::string_view name, const std::size_t repetitions, const std::function<std::size_t()>& run,
+             const std::function<void()>& prepare = {})
+{
+    auto best       = std::chrono::nanoseconds::max();
+    auto operations = std::size_t{0};
+    for (auto i = std::size_t{0}; i < repetitions; ++i)
+    {
+        if (prepare)
+        {
+            prepare();
+        }
+        const auto start = std::chrono::steady_clock::now();
+        operations       = run();
+        best             = std::min(best, std::chrono::steady_clock::now() - start);
+    }
+
+    const auto nsPerOperation = operations == 0 ? 0.0 : static_cast<double>(best.count()) / operations;
+    std::cout << name << std::string(name.size() < 48 ? 48 - name.size() : 1, ' ') << operations << " ops  "
+              << nsPerOperation << " ns/op" << std::endl;
+}
+
+void benchmarkParser(const Options& options, const Workloads& workloads)
+{
+    // Every supported scanner is measured, the fastest one is selected again at the end
+    const auto scanners = supportedByteScanners();
+    for (auto scanner = scanners.rbegin(); scanner != scanners.rend(); ++scanner)
+    {
+        selectByteScanner(*scanner);
+        for (const auto& [kind, batch] : workloads)
+        {
+            measure(std::format("CommandParser::getNextCommand ({}, {})", workloadKindToString(kind), *scanner),
+                    options.repetitions,
+                    [&batch]()
+                    {
+                        auto parser   = CommandParser{batch};
+                        auto commands = std::size_t{0};
+                        while (parser.hasMoreInput())
+                        {
+                            commands += parser.getNextCommand().hasError() ? 0 : 1;
+                        }
+                        return commands;
+                    });
+        }
+    }
+}
+
+void benchmarkPathResolution(const Options& options, const std::string& deepBatch)
+{
+    // parsePath() and findNodeByPath() are private, so they are measured via the command, which only resolves
+    // the path: mf of the existing file neither changes the tree nor logs at the Off level
+    auto path = std::string{"/b0"};
+    for (auto depth = std::size_t{1}; depth < resolvedDepth; ++depth)
+    {
+        path += std::format("/d{}", depth);
+    }
+    auto messyPath = path;
+    for (auto pos = messyPath.find('/'); pos != std::string::npos; pos = messyPath.find('/', pos + 3))
+    {
+        messyPath.replace(pos, 1, " // ");
+    }
+
+    const auto file       = path + "/existing.txt";
+    const auto messyFile  = messyPath + "/existing.txt";
+    const auto iterations = options.commandsNumber;
+
+    for (const auto cacheCapacity : {std::size_t{1024}, std::size_t{0}})
+    {
+        auto emulator = makeEmulator(deepBatch);
+        emulator.fme->setPathCacheCapacity(cacheCapacity);
+        if (!emulator.fme->mf(file) || !emulator.fme->mf(messyFile))
+        {
+            std::cerr << "The resolved path is not found" << std::endl;
+        }
+
+        const auto suffix = cacheCapacity == 0 ? ", no cache" : ", cache";
+        measure(std::format("resolve depth {}{}", resolvedDepth, suffix), options.repetitions,
+                [&emulator, &file, iterations]()
+                {
+                    for (auto i = std::size_t{0}; i < iterations; ++i)
+                    {
+                        emulator.fme->mf(file);
+                    }
+                    return iterations;
+                });
+        measure(std::format("resolve depth {} unnormalized{}", resolvedDepth, suffix), options.repetitions,
+                [&emulator, &messyFile, iterations]()
+                {
+                    for (auto i = std::size_t{0}; i < iterations; ++i)
+                    {
+                        emulator.fme->mf(messyFile);
+                    }
+                    return iterations;
+                });
+    }
+}
+
+void benchmarkCopy(const Options& options)
+{
+    auto storage = FsNodeStorage{};
+    auto source  = storage.createNode("source", true);
+    for (auto i = std::size_t{0}; i < options.commandsNumber; ++i)
+    {
+        source->addChild(storage, storage.createNode(std::format("f{}", i), false));
+    }
+
+    const auto iterations = options.commandsNumber;
+    measure(std::format("FsNode::copy ({} children)", options.commandsNumber), options.repetitions,
+            [&storage, &source, iterations]()
+            {
+                for (auto i = std::size_t{0}; i < iterations; ++i)
+                {
+                    static_cast<void>(source->copy(storage, "copy"));
+                }
+                return iterations;
+            });
+}
+
+void benchmarkPrint(const Options& options, const std::string& wideBatch)
+{
+    auto emulator = makeEmulator(wideBatch, LogLevel::Info);
+    measure("printFileTree (per node)", options.repetitions,
+            [&emulator, nodes = options.commandsNumber]()
+            {
+                emulator.fme->printFileTree();
+                return nodes;
+            });
+}
+
+void benchmarkRun(const Options& options, const Workloads& workloads, const LogLevel logLevel)
+{
+    for (const auto& [kind, batch] : workloads)
+    {
+        auto emulator = Emulator{};
+        measure(std::format("run ({}, {})", workloadKindToString(kind),
+                            logLevel == LogLevel::Off ? "no log" : "formatted log"),
+                options.repetitions,
+                [&emulator, &batch, commands = options.commandsNumber]()
+                {
+                    emulator.fme->runCommands(batch);
+                    return commands;
+                },
+                [&emulator, logLevel]() { emulator = makeEmulator("", logLevel); });
+    }
+}
+
+std::optional<std::size_t> parseNumber(const std::string_view value)
+{
+    auto       number       = std::size_t{0};
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (value.empty() || error != std::errc{} || end != value.data() + value.size())
+    {
+        return std::nullopt;
+    }
+    return number;
+}
+
+std::optional<Options> parseOptions(const int argc, char** argv)
+{
+    constexpr auto commandsOption    = std::string_view{"--commands="};
+    constexpr auto repetitionsOption = std::string_view{"--repetitions="};
+    constexpr auto seedOption        = std::string_view{"--seed="};
+    constexpr auto generateOption    = std::string_view{"--generate="};
+    auto           options           = Options{};
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const auto arg    = std::string_view{argv[i]};
+        auto       number = std::optional<std::size_t>{};
+        auto       kind   = std::optional<WorkloadKind>{};
+
+        if (arg.starts_with(commandsOption) && (number = parseNumber(arg.substr(commandsOption.size()))))
+        {
+            options.commandsNumber = std::max(*number, std::size_t{1});
+        }
+        else if (arg.starts_with(repetitionsOption) && (number = parseNumber(arg.substr(repetitionsOption.size()))))
+        {
+            options.repetitions = std::max(*number, std::size_t{1});
+        }
+        else if (arg.starts_with(seedOption) && (number = parseNumber(arg.substr(seedOption.size()))))
+        {
+            options.seed = static_cast<std::uint32_t>(*number);
+        }
+        else if (arg.starts_with(generateOption) && (kind = parseWorkloadKind(arg.substr(generateOption.size()))))
+        {
+            options.generate = kind;
+        }
+        else
+        {
+            std::cerr << "Invalid argument: " << arg << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const auto options = parseOptions(argc, argv);
+    if (!options)
+    {
+        std::cerr << "Usage: " << argv[0] << usage << std::endl;
+        return 1;
+    }
+
+    if (options->generate)
+    {
+        std::cout << generateWorkload(*options->generate, options->commandsNumber, options->seed);
+        return 0;
+    }
+
+    auto workloads = Workloads{};
+    for (const auto kind : {WorkloadKind::Deep, WorkloadKind::Wide, WorkloadKind::CopyMove})
+    {
+        workloads.emplace_back(kind, generateWorkload(kind, options->commandsNumber, options->seed));
+    }
+
+    benchmarkParser(*options, workloads);
+    benchmarkPathResolution(*options, workloads[0].second);
+    benchmarkCopy(*options);
+    benchmarkPrint(*options, workloads[1].second);
+    benchmarkRun(*options, workloads, LogLevel::Off);
+    benchmarkRun(*options, workloads, LogLevel::Info);
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "workload_generator.h"
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <random>
+#include <utility>
+
+namespace
+{
+constexpr inline auto maxDepth          = std::size_t{64};
+constexpr inline auto filesPerDirectory = std::size_t{16};
+constexpr inline auto sourceDirectories = std::size_t{8};
+constexpr inline auto sourceFiles       = std::size_t{4};
+constexpr inline auto keptCopies        = std::size_t{4};  // The moved copies, which are alive at once
+
+/**
+ * \brief Appends the commands to the batch until the requested number of the commands is reached.
+ */
+class BatchWriter final
+{
+    public:
+        explicit BatchWriter(const std::size_t commandsNumber) : m_commandsNumber{commandsNumber} {}
+
+        template<typename... Args>
+        bool add(std::format_string<Args...> format, Args&&... args)
+        {
+            if (full())
+            {
+                return false;
+            }
+            std::format_to(std::back_inserter(m_batch), format, std::forward<Args>(args)...);
+            m_batch.push_back('\n');
+            ++m_written;
+            return true;
+        }
+
+        bool        full() const noexcept
+        {
+            return m_written >= m_commandsNumber;
+        }
+
+        std::string release()
+        {
+            return std::move(m_batch);
+        }
+
+    private:
+        std::string m_batch;
+        std::size_t m_commandsNumber = 0;
+        std::size_t m_written        = 0;
+};
+
+void generateDeep(BatchWriter& batch, std::mt19937& random)
+{
+    auto path = std::string{};
+    for (auto branch = std::size_t{0}, depth = std::size_t{0}, file = std::size_t{0}; !batch.full();)
+    {
+        if (depth == maxDepth)
+        {
+            path.clear();
+            depth = 0;
+            ++branch;
+        }
+
+        if (depth != 0 && random() % 4 == 0)
+        {
+            batch.add("mf {}/f{}.txt", path, file++);
+        }
+        else
+        {
+            path += depth == 0 ? std::format("/b{}", branch) : std::format("/d{}", depth);
+            batch.add("md {}", path);
+            ++depth;
+        }
+    }
+}
+
+void generateWide(BatchWriter& batch, std::mt19937& random, const std::size_t commandsNumber)
+{
+    const auto directories = std::max(commandsNumber / filesPerDirectory, std::size_t{1});
+    for (auto i = std::size_t{0}; i < directories; ++i)
+    {
+        batch.add("md /w{}", i);
+    }
+    for (auto file = std::size_t{0}; !batch.full(); ++file)
+    {
+        batch.add("mf /w{}/f{}.txt", random() % directories, file);
+    }
+}
+
+void generateCopyMove(BatchWriter& batch, std::mt19937& random)
+{
+    batch.add("md /src");
+    for (auto i = std::size_t{0}; i < sourceDirectories; ++i)
+    {
+        batch.add("md /src/d{}", i);
+        for (auto j = std::size_t{0}; j < sourceFiles; ++j)
+        {
+            batch.add("mf /src/d{}/f{}.txt", i, j);
+        }
+    }
+
+    // Every copy is modified, so the shared contents are cloned, and then it is moved and removed later
+    for (auto copy = std::size_t{0}; !batch.full(); ++copy)
+    {
+        batch.add("cp /src /c{}", copy);
+        batch.add("mf /c{}/d{}/new{}.txt", copy, random() % sourceDirectories, copy);
+        batch.add("mv /c{} /m{}", copy, copy);
+        if (copy >= keptCopies)
+        {
+            batch.add("rm /m{}", copy - keptCopies);
+        }
+    }
+}
+
+}  // namespace
+
+std::optional<WorkloadKind> parseWorkloadKind(const std::string_view name)
+{
+    for (const auto kind : {WorkloadKind::Deep, WorkloadKind::Wide, WorkloadKind::CopyMove})
+    {
+        if (name == workloadKindToString(kind))
+        {
+            return kind;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string_view workloadKindToString(const WorkloadKind kind)
+{
+    switch (kind)
+    {
+        case WorkloadKind::Deep:
+            return "deep";
+        case WorkloadKind::Wide:
+            return "wide";
+        case WorkloadKind::CopyMove:
+            return "cpmv";
+        default:
+            return "";
+    }
+}
+
+std::string generateWorkload(const WorkloadKind kind, const std::size_t commandsNumber, const std::uint32_t seed)
+{
+    auto batch  = BatchWriter{commandsNumber};
+    auto random = std::mt19937{seed};
+
+    switch (kind)
+    {
+        case WorkloadKind::Deep:
+            generateDeep(batch, random);
+            break;
+        case WorkloadKind::Wide:
+            generateWide(batch, random, commandsNumber);
+            break;
+        case WorkloadKind::CopyMove:
+            generateCopyMove(batch, random);
+            break;
+    }
+    return batch.release();
+}
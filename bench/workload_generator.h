@@ -0,0 +1,41 @@
+#ifndef WORKLOAD_GENERATOR_H
+#define WORKLOAD_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * \brief WorkloadKind defines the shape of the generated batch.
+ */
+enum class WorkloadKind
+{
+    Deep,     /// Long chains of nested directories with files along them.
+    Wide,     /// Many directories in the root with many files in each of them.
+    CopyMove  /// Repeated copying, modification, moving and removal of a prebuilt subtree.
+};
+
+/**
+ * \brief Returns the kind by its name ("deep", "wide" or "cpmv").
+ */
+std::optional<WorkloadKind> parseWorkloadKind(std::string_view name);
+
+/**
+ * \brief Returns the name of the kind.
+ */
+std::string_view workloadKindToString(WorkloadKind kind);
+
+/**
+ * \brief Generates the batch of the commands, which are executed without errors on the empty tree.
+ *
+ * The batch is reproducible: the same arguments give the same batch.
+ *
+ * \param kind The shape of the batch.
+ * \param commandsNumber The number of the commands in the batch.
+ * \param seed The seed of the random choices.
+ */
+std::string generateWorkload(WorkloadKind kind, std::size_t commandsNumber, std::uint32_t seed = 1);
+
+#endif  // WORKLOAD_GENERATOR_H
@@ -0,0 +1,82 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+#include "spsc_queue.h"
+
+/**
+ * \brief Logger, which writes messages into the sink on the background thread.
+ *
+ * Messages are appended into the large buffer. The full buffer is handed over to the writer thread
+ * via a lock-free queue and the next free buffer is taken, so the logging thread neither flushes
+ * nor waits for the sink while there is a free buffer. The writer writes each buffer with one call.
+ *
+ * The messages are written only from one thread (the logger isn't thread-safe for the callers).
+ * Buffered messages are written into the sink by flush() and in the destructor.
+ */
+class AsyncLogger final : public Logger
+{
+    public:
+        /**
+         * \brief Constructs an AsyncLogger and starts the writer thread.
+         *
+         * \param sink The output stream for the messages. The logger doesn't take ownership of the stream.
+         * \param minLevel Messages with lower level are not logged.
+         * \param bufferSize The size of one buffer in bytes.
+         * \param buffersNumber The number of buffers (at least 2).
+         */
+        explicit AsyncLogger(std::ostream& sink, LogLevel minLevel = LogLevel::Info,
+                             std::size_t bufferSize = 256 * 1024, std::size_t buffersNumber = 4);
+        AsyncLogger(const AsyncLogger&) = delete;
+        AsyncLogger(AsyncLogger&&)      = delete;
+
+        ~AsyncLogger() override;
+
+        AsyncLogger& operator=(const AsyncLogger&) = delete;
+        AsyncLogger& operator=(AsyncLogger&&)      = delete;
+
+        /**
+         * \brief Hands over the current buffer and waits until all messages are written into the sink.
+         */
+        void flush() override;
+
+    protected:
+        bool finishLog() override;
+        bool writeLog(std::string_view log) override;
+        bool writeLogChunk(std::string_view chunk) override;
+
+    private:
+        /**
+         * \brief Appends the text into the current buffer and hands over the buffers, which become full.
+         */
+        bool append(std::string_view text);
+        /**
+         * \brief Hands over the current buffer to the writer thread and takes the next free buffer.
+         */
+        void submitCurrentBuffer();
+        /**
+         * \brief The main function of the writer thread.
+         */
+        void writeBuffers();
+
+    private:
+        std::ostream&            m_sink;
+        std::size_t              m_bufferSize = 0;
+        std::vector<std::string> m_buffers;
+        SpscQueue<std::string*>  m_filledBuffers;
+        SpscQueue<std::string*>  m_freeBuffers;
+        std::string*             m_currentBuffer    = nullptr;
+        std::size_t              m_submittedBuffers = 0;
+        std::atomic<std::size_t> m_writtenBuffers   = 0;
+        std::atomic<bool>        m_sinkFailed       = false;
+        std::thread              m_writer;  // Must be the last member: the thread uses all other members
+};
+
+#endif  // ASYNC_LOGGER_H
@@ -0,0 +1,58 @@
+#ifndef BYTE_SCANNER_H
+#define BYTE_SCANNER_H
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+/**
+ * \brief ByteClass defines the bytes searched by the scanner.
+ */
+enum class ByteClass
+{
+    Space,    /// ' ', '\t', '\n', '\v', '\f' and '\r' (the same bytes as std::isspace() in the "C" locale).
+    Quote,    /// '"'
+    Newline,  /// '\n'
+    Slash     /// '/'
+};
+
+/**
+ * \brief Checks whether the byte belongs to the class.
+ */
+bool isByteOf(unsigned char c, ByteClass byteClass) noexcept;
+
+/**
+ * \brief Returns the position of the first byte of the class starting from pos (str.size() if there is no such a byte).
+ *
+ * The bytes are classified by the vector instructions 16 or 32 bytes at a time (the scanner is selected at runtime).
+ */
+std::size_t findByteOf(std::string_view str, ByteClass byteClass, std::size_t pos = 0) noexcept;
+
+/**
+ * \brief Returns the position of the first byte not of the class starting from pos (str.size() if there is no such
+ * a byte).
+ */
+std::size_t skipBytesOf(std::string_view str, ByteClass byteClass, std::size_t pos = 0) noexcept;
+
+/**
+ * \brief Returns the names of the scanners supported by the processor, the first one is the fastest.
+ *
+ * The names are "avx2", "sse2", "neon" and "scalar" (the scalar scanner is always supported).
+ */
+std::span<const std::string_view> supportedByteScanners() noexcept;
+
+/**
+ * \brief Returns the name of the scanner used by findByteOf() and skipBytesOf().
+ */
+std::string_view byteScannerName() noexcept;
+
+/**
+ * \brief Selects the scanner by name (for example, to compare the scanners).
+ *
+ * The scanner isn't synchronized, so it must be selected before the scanning starts on other threads.
+ *
+ * \return false if the scanner isn't supported (the current scanner isn't changed).
+ */
+bool selectByteScanner(std::string_view name) noexcept;
+
+#endif  // BYTE_SCANNER_H
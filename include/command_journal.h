@@ -0,0 +1,108 @@
+#ifndef COMMAND_JOURNAL_H
+#define COMMAND_JOURNAL_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "fs_node.h"
+#include "fs_snapshot.h"
+
+/**
+ * \brief CommandJournal is the append-only journal of the successfully applied commands with the checkpoints.
+ *
+ * The journal is a text file with one command per line, so it has the format of the batch files.
+ * The commands are collected in the buffer and written in groups (group commit), so journaling costs
+ * only one copy of the command string per command.
+ *
+ * A checkpoint is the snapshot of the tree with the header, which stores the size of the journal and
+ * the number of the commands applied at the moment of the checkpoint. The state is restored by loading
+ * of the checkpoint and replaying of the journal after the stored size. The checkpoint is written into
+ * the temporary file and renamed, so a failure during writing keeps the previous checkpoint.
+ */
+class CommandJournal final
+{
+    public:
+        /**
+         * \brief Checkpoint describes the position of the checkpoint in the journal.
+         */
+        struct Checkpoint
+        {
+                std::uint64_t journalSize    = 0;  /// The size of the journal in bytes.
+                std::uint64_t commandsNumber = 0;  /// The number of the commands applied before the checkpoint.
+        };
+
+    public:
+        /**
+         * \brief Constructs a CommandJournal. The files are not opened.
+         *
+         * \param path The path of the journal. The checkpoint is stored in the file with the ".checkpoint" suffix.
+         */
+        explicit CommandJournal(std::string_view path);
+        CommandJournal(const CommandJournal&) = delete;
+        CommandJournal(CommandJournal&&)      = delete;
+
+        /**
+         * \brief Writes the buffered commands.
+         */
+        ~CommandJournal();
+
+        CommandJournal& operator=(const CommandJournal&) = delete;
+        CommandJournal& operator=(CommandJournal&&)      = delete;
+
+        /**
+         * \brief Adds the command to the journal. The full group of the commands is written into the file.
+         */
+        bool               append(std::string_view commandString);
+        /**
+         * \brief Returns the path of the checkpoint file.
+         */
+        const std::string& checkpointPath() const noexcept;
+        /**
+         * \brief Returns the number of the journaled commands (including the commands before the checkpoint).
+         */
+        std::uint64_t      commandsNumber() const noexcept;
+        /**
+         * \brief Writes the buffered commands into the file.
+         */
+        bool               commit();
+        /**
+         * \brief Opens the journal after the restoring of the state for appending of the next commands.
+         *
+         * \param journalSize The size of the restored part of the journal, the rest of the file is dropped
+         *        (for example, the incomplete last line).
+         * \param commandsNumber The number of the restored commands.
+         */
+        bool               continueAt(std::uint64_t journalSize, std::uint64_t commandsNumber);
+        /**
+         * \brief Returns the path of the journal file.
+         */
+        const std::string& path() const noexcept;
+        /**
+         * \brief Reads the checkpoint.
+         *
+         * \param storage The storage for the nodes of the restored tree.
+         * \param root Receives the root of the restored tree.
+         * \param checkpoint Receives the position of the checkpoint in the journal.
+         */
+        SnapshotError      readCheckpoint(FsNodeStorage& storage, FsNodePtr& root, Checkpoint& checkpoint) const;
+        /**
+         * \brief Starts the new empty journal, the previous journal and its checkpoint are removed.
+         */
+        bool               start();
+        /**
+         * \brief Commits the buffered commands and writes the checkpoint of the tree.
+         */
+        SnapshotError      writeCheckpoint(const FsNode& root);
+
+    private:
+        std::string   m_path;
+        std::string   m_checkpointPath;
+        std::ofstream m_file;
+        std::string   m_buffer;             // The group of the commands, which are not written yet
+        std::uint64_t m_committedSize  = 0;  // The size of the file
+        std::uint64_t m_commandsNumber = 0;
+};
+
+#endif  // COMMAND_JOURNAL_H
@@ -1,14 +1,17 @@
 #ifndef COMMAND_PARSER_H
 #define COMMAND_PARSER_H
 
+#include <iosfwd>
+#include <string>
 #include <string_view>
 
 #include "command_type.h"
 
 /**
- * \brief A parser for user-input commands from an input stream.
+ * \brief A parser for user-input commands from an input stream or from the memory.
  *
- * The CommandParser class is responsible for reading commands from an input stream,
+ * The CommandParser class is responsible for reading commands from an input stream
+ * (or from the memory, for example, a memory-mapped batch file, or from the file descriptor),
  * interpreting them, and returning Command objects.
  * It supports commands such as `cp`, `md`, `mf`, `mv`, `rm`, as well
  * as error handling for invalid or malformed input.
@@ -27,56 +30,108 @@ class CommandParser final
          *        The parser does not take ownership of the stream.
          */
         explicit CommandParser(std::istream& inputStream);
+        /**
+         * \brief Constructs a CommandParser, which reads commands from the memory.
+         *
+         * \param input The text with commands (for example, the content of a memory-mapped batch file).
+         *        The parser doesn't copy the input, so the input must outlive the parser.
+         */
+        explicit CommandParser(std::string_view input);
+        /**
+         * \brief Constructs a CommandParser, which reads commands from the file descriptor (for example, a pipe).
+         *
+         * The descriptor is read directly by large blocks and the complete lines are parsed from the buffer,
+         * so a command is returned as soon as its line is read. The parser doesn't close the descriptor.
+         * The descriptors are read only if canReadDescriptors() is true.
+         */
+        explicit CommandParser(int fileDescriptor);
+
+        /**
+         * \brief Checks whether the parser can read the file descriptors (on POSIX systems only).
+         */
+        static bool      canReadDescriptors() noexcept;
 
         /**
          * \brief Returns the string representation of the CommandName.
          */
-        std::string commandNameToString(CommandName command) const;
+        std::string_view commandNameToString(CommandName command) const;
+        /**
+         * \brief Returns the description of the parsing error.
+         */
+        std::string_view errorToString(CommandErrorCode errorCode) const;
         /**
          * \brief Reads and parses the next command from the input stream.
          *
+         * The strings of the command are valid until the next call (until the end of the memory input).
+         *
          * \return A Command structure representing the parsed command.
-         *         If parsing fails, the `error` field is set with a description.
+         *         If parsing fails, the `error` field describes the error.
+         */
+        Command          getNextCommand();
+        /**
+         * \brief Checks whether the next command is already read, so getNextCommand() doesn't wait for the input.
+         *
+         * The memory input is always read, the stream input is never considered as read.
          */
-        Command getNextCommand();
+        bool             hasBufferedCommand() const noexcept;
         /**
          * \brief Checks if there is more input to be parsed.
          *
          * \return True if there is more data in the input stream, false otherwise.
          */
-        bool    hasMoreInput();
+        bool             hasMoreInput();
 
     private:
+        /**
+         * \brief Creates a command from the command line.
+         *
+         * \param commandString The whole command line (starting from the command name).
+         */
+        Command     makeCommand(std::string_view commandString) const;
+        /**
+         * \brief Reads the next command from the memory input.
+         */
+        Command     getNextMemoryCommand();
+        /**
+         * \brief Reads the next command from the input stream.
+         */
+        Command     getNextStreamCommand();
+        /**
+         * \brief Reads the next block of the file descriptor, the parsed lines are dropped from the buffer.
+         *
+         * \return false if the input is over (or the parser doesn't read the descriptor).
+         */
+        bool        readDescriptor();
         /**
          * \brief Converts a raw string into a CommandName.
          *
          * \param commandStr The raw command string (e.g., "cp", "md").
          * \return The corresponding CommandName enum value, or Unknown if invalid.
          */
-        CommandName              parseCommandName(std::string_view commandStr) const;
+        CommandName parseCommandName(std::string_view commandStr) const;
         /**
          * \brief Parses arguments from a command string.
          *
-         * Handles quoted strings and whitespace-separated tokens.
+         * Handles quoted strings and whitespace-separated tokens. The unquoted tokens with the wildcards are patterns.
          *
-         * \param commandStr The raw command string (excluding the command name).
-         * \param outParsingError Output parameter for error messages, if any.
-         * \return A vector of parsed arguments.
+         * \param command The command to fill with the arguments or the error.
+         * \param argumentsOffset The offset of the arguments in the command string (after the command name).
          */
-        std::vector<std::string> parseCommandArguments(std::string_view            commandStr,
-                                                       std::optional<std::string>& outParsingError) const;
+        void        parseCommandArguments(Command& command, std::size_t argumentsOffset) const;
         /**
          * \brief Helper: splits arguments by whitespace.
          *
-         * \param parsedArguments Vector to append parsed arguments into.
+         * \param command The command to append parsed arguments into.
          * \param commandStr The part of the command string, which contains arguments.
          */
-        void                     parseCommandArgumentsByWhitespaces(std::vector<std::string>& parsedArguments,
-                                                                    std::string_view          commandStr) const;
+        void        parseCommandArgumentsByWhitespaces(Command& command, std::string_view commandStr) const;
 
     private:
-        std::istream& m_inStream;
-
+        std::istream*    m_inStream = nullptr;  // Null if the parser reads the memory input
+        std::string      m_lineBuffer;          // The last line read from the stream or the block of the descriptor
+        std::string_view m_input;               // The memory input or the read part of the block of the descriptor
+        std::size_t      m_inputPos       = 0;
+        int              m_fileDescriptor = -1;  // -1 if the parser doesn't read the descriptor or its input is over
 };
 
 #endif  // COMMAND_PARSER_H
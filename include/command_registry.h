@@ -0,0 +1,187 @@
+#ifndef COMMAND_REGISTRY_H
+#define COMMAND_REGISTRY_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "command_type.h"
+
+/**
+ * \brief CommandSpec describes the command: its name in the input and the number of its arguments.
+ */
+struct CommandSpec final
+{
+        std::string_view name;
+        CommandName      command;
+        std::size_t      argumentsNumber;
+};
+
+/**
+ * \brief The registry of the commands, the specs are ordered as CommandName.
+ *
+ * A new command is added to CommandName, here and to the handlers of the FileManagerEmulator::executeCommand()
+ * (the compilation fails if the command is missed somewhere). The lookup by name stays one hash and one comparison.
+ */
+constexpr inline auto commandSpecs = std::array{
+  CommandSpec{"begin", CommandName::Begin, 0},
+  CommandSpec{"commit", CommandName::Commit, 0},
+  CommandSpec{"cp", CommandName::Cp, 2},
+  CommandSpec{"du", CommandName::Du, 1},
+  CommandSpec{"md", CommandName::Md, 1},
+  CommandSpec{"mf", CommandName::Mf, 1},
+  CommandSpec{"mv", CommandName::Mv, 2},
+  CommandSpec{"rm", CommandName::Rm, 1}
+};
+
+constexpr inline auto commandsNumber     = commandSpecs.size();
+constexpr inline auto commandsHashBits   = 4U;  // The sparse table of 16 slots: the perfect hash is found quickly
+constexpr inline auto maxCommandNameSize = []
+{
+    auto size = std::size_t{0};
+    for (const auto& spec : commandSpecs)
+    {
+        size = std::max(size, spec.name.size());
+    }
+    return size;
+}();
+
+static_assert(commandsNumber == static_cast<std::size_t>(CommandName::Unknown), "Every command must have a spec");
+static_assert(
+  []
+  {
+      for (auto i = std::size_t{0}; i < commandsNumber; ++i)
+      {
+          if (static_cast<std::size_t>(commandSpecs[i].command) != i
+              || commandSpecs[i].argumentsNumber > Command::maxArgumentsNumber)
+          {
+              return false;
+          }
+      }
+      return true;
+  }(),
+  "The specs must be ordered as CommandName and must not accept more than Command::maxArgumentsNumber arguments");
+
+static_assert(maxCommandNameSize <= sizeof(std::uint64_t), "The command names are hashed as 64-bit keys");
+
+/**
+ * \brief Returns the name packed into the 64-bit key (the names longer than 8 bytes aren't commands).
+ */
+constexpr std::uint64_t commandNameKey(const std::string_view name) noexcept
+{
+    auto key = std::uint64_t{0};
+    for (auto i = std::size_t{0}; i < name.size(); ++i)
+    {
+        key |= std::uint64_t{static_cast<unsigned char>(name[i])} << (8U * i);
+    }
+    return key;
+}
+
+/**
+ * \brief Returns the slot of the key in the table of the commands (the multiply-shift hash).
+ */
+constexpr std::size_t commandNameHash(const std::uint64_t key, const std::uint64_t multiplier) noexcept
+{
+    return static_cast<std::size_t>((key * multiplier) >> (64U - commandsHashBits));
+}
+
+/**
+ * \brief Finds the multiplier, for which the hashes of all command names are different (the perfect hash).
+ */
+consteval std::uint64_t findCommandsHashMultiplier()
+{
+    for (auto attempt = std::uint64_t{1}; attempt <= 10000; ++attempt)
+    {
+        const auto multiplier = (attempt * 0x9E3779B97F4A7C15U) | 1U;  // The odd multiples of the golden ratio
+
+        auto used      = std::array<bool, std::size_t{1} << commandsHashBits>{};
+        auto collision = false;
+        for (const auto& spec : commandSpecs)
+        {
+            auto& slot = used[commandNameHash(commandNameKey(spec.name), multiplier)];
+            collision  = collision || slot;
+            slot       = true;
+        }
+        if (!collision)
+        {
+            return multiplier;
+        }
+    }
+    throw "No perfect hash of the command names is found: increase commandsHashBits";
+}
+
+constexpr inline auto commandsHashMultiplier = findCommandsHashMultiplier();
+constexpr inline auto commandsTable          = []
+{
+    auto table = std::array<CommandName, std::size_t{1} << commandsHashBits>{};
+    table.fill(CommandName::Unknown);
+    for (const auto& spec : commandSpecs)
+    {
+        table[commandNameHash(commandNameKey(spec.name), commandsHashMultiplier)] = spec.command;
+    }
+    return table;
+}();
+
+/**
+ * \brief Returns the spec of the known command.
+ */
+constexpr const CommandSpec& commandSpec(const CommandName command) noexcept
+{
+    return commandSpecs[static_cast<std::size_t>(command)];
+}
+
+/**
+ * \brief Returns the command by its name or CommandName::Unknown.
+ */
+constexpr CommandName findCommand(const std::string_view name) noexcept
+{
+    if (name.size() > maxCommandNameSize)
+    {
+        return CommandName::Unknown;
+    }
+    const auto command = commandsTable[commandNameHash(commandNameKey(name), commandsHashMultiplier)];
+    return command != CommandName::Unknown && commandSpec(command).name == name ? command : CommandName::Unknown;
+}
+
+static_assert(std::all_of(commandSpecs.begin(), commandSpecs.end(),
+                          [](const CommandSpec& spec) { return findCommand(spec.name) == spec.command; }));
+
+/**
+ * \brief CommandHandler binds the handler to the command.
+ */
+template<typename Handler>
+struct CommandHandler final
+{
+        CommandName command;
+        Handler     handler;
+};
+
+/**
+ * \brief Orders the handlers as CommandName, so the handler of the command is found by the index.
+ *
+ * The compilation fails if a command has no handler or several handlers.
+ */
+template<typename Handler, std::size_t HandlersNumber>
+consteval std::array<Handler, commandsNumber> makeCommandHandlers(
+  const std::array<CommandHandler<Handler>, HandlersNumber>& handlers)
+{
+    static_assert(HandlersNumber == commandsNumber, "Every command must have one handler");
+
+    auto table = std::array<Handler, commandsNumber>{};
+    auto bound = std::array<bool, commandsNumber>{};
+    for (const auto& [command, handler] : handlers)
+    {
+        const auto index = static_cast<std::size_t>(command);
+        if (index >= commandsNumber || bound[index])
+        {
+            throw "The handler is bound to the unknown command or the command has several handlers";
+        }
+        table[index] = handler;
+        bound[index] = true;
+    }
+    return table;
+}
+
+#endif  // COMMAND_REGISTRY_H
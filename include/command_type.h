@@ -1,16 +1,20 @@
 #ifndef COMMAND_TYPE_H
 #define COMMAND_TYPE_H
 
-#include <optional>
-#include <string>
-#include <vector>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string_view>
 
 /**
  * \brief Enumeration of valid commands recognized by the File Manager Emulator.
  */
 enum class CommandName
 {
+    Begin,
+    Commit,
     Cp,
+    Du,
     Md,
     Mf,
     Mv,
@@ -18,18 +22,78 @@ enum class CommandName
     Unknown
 };
 
+/**
+ * \brief Enumeration of the errors of the command parsing.
+ */
+enum class CommandErrorCode
+{
+    NoError,
+    UnknownCommand,       /// The command name is unknown.
+    EmptyArgument,        /// The quoted argument is empty ("").
+    ClosingQuotesMissing  /// The closing quotes of the quoted argument are not found.
+};
+
+/**
+ * \brief CommandError describes the parsing error and the position of the erroneous part of the command.
+ */
+struct CommandError final
+{
+        CommandErrorCode code   = CommandErrorCode::NoError;
+        std::size_t      offset = 0;  /// The offset of the erroneous part in the Command::commandString.
+        std::size_t      length = 0;  /// The length of the erroneous part.
+};
+
 /**
  * \brief Parsed command structure.
  *
  * Represents a fully parsed command line, containing the command name,
- * its arguments, and optionally an error string if parsing failed.
+ * its arguments, and the error if parsing failed.
+ *
+ * The command doesn't own the strings: the command string and the arguments are views into the input
+ * of the CommandParser, they are valid until the next command is read (or until the end of the input
+ * for the memory input of the parser).
  */
 struct Command final
 {
-        std::string                commandString;
-        CommandName                name = CommandName::Unknown;
-        std::vector<std::string>   arguments;
-        std::optional<std::string> error;
+        /// No command accepts more arguments, only the number of the extra arguments is stored.
+        static constexpr std::size_t maxArgumentsNumber = 2;
+
+        std::string_view                                 commandString;  /// The command name for unknown commands.
+        CommandName                                      name = CommandName::Unknown;
+        std::array<std::string_view, maxArgumentsNumber> arguments;
+        std::size_t                                      argumentsNumber = 0;  /// The number of all passed arguments.
+        /// The unquoted arguments with the wildcards '*' or '?' (the quoted arguments are always literal).
+        std::array<bool, maxArgumentsNumber>             patterns        = {};
+        CommandError                                     error;
+
+        /// Checks whether the parsing of the command failed.
+        bool             hasError() const noexcept
+        {
+            return error.code != CommandErrorCode::NoError;
+        }
+
+        /// Returns the erroneous part of the command string.
+        std::string_view errorPart() const noexcept
+        {
+            return commandString.substr(error.offset, error.length);
+        }
+
+        /**
+         * \brief Returns the same command, which refers to the copy of the command string.
+         *
+         * The arguments are views into the command string, so they are moved into the copy by the offsets.
+         */
+        Command          rebased(const std::string_view commandStringCopy) const noexcept
+        {
+            auto result          = *this;
+            result.commandString = commandStringCopy;
+            for (auto i = std::size_t{0}; i < std::min(argumentsNumber, maxArgumentsNumber); ++i)
+            {
+                const auto offset   = static_cast<std::size_t>(arguments[i].data() - commandString.data());
+                result.arguments[i] = commandStringCopy.substr(offset, arguments[i].size());
+            }
+            return result;
+        }
 };
 
 #endif  // COMMAND_TYPE_H
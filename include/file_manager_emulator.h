@@ -1,14 +1,21 @@
 #ifndef FILE_MANAGER_EMULATOR_H
 #define FILE_MANAGER_EMULATOR_H
 
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <memory>
-#include <unordered_map>
+#include <string>
+#include <string_view>
 
 #include "command_type.h"
+#include "fme_metrics.h"
+#include "fs_tree.h"
 
+class CommandJournal;
 class CommandParser;
 class Logger;
+class MappedFile;
 
 /**
  * \brief ErrorCode represents possible execution outcomes of the FileManagerEmulator.
@@ -20,7 +27,17 @@ enum class ErrorCode
     CommandParsingError,    /// Invalid or unknown command syntax.
     CommandArgumentsError,  /// Incorrect number or type of command arguments.
     LogicError,             /// Runtime logic error during command execution.
-    UknownException         /// Some exception was thrown
+    UknownException,        /// Some exception was thrown
+    JournalError            /// Writing of the journal or of the checkpoint failed.
+};
+
+/**
+ * \brief TreeOutput defines how the file tree is printed after the execution.
+ */
+enum class TreeOutput
+{
+    Full,    /// The whole tree.
+    Changes  /// Only the changed items with their ancestors, compared with the tree before the execution.
 };
 
 /**
@@ -30,61 +47,20 @@ enum class ErrorCode
  * FME is a virtual, in-memory file system. It doesn't 
  * interact with the real disk but instead emulates file operations such as
  * creating, removing, copying, and moving files or directories.
- * FME can execute commands from the batch file or from standard input.
+ * FME can execute commands from the batch file or from standard input. Standard input is read directly by large
+ * blocks, and the log is flushed only when the next command isn't read yet, so the commands piped ahead by another
+ * process are answered without waiting for every reply.
  * In the result of execution it outputs a formatted directory tree or
  * an error message if execution fails.
+ *
+ * The tree operations are performed by FsTree, FME logs their results.
+ *
+ * The commands between "begin" and "commit" are executed as a transaction: if the batch fails before the commit,
+ * the changes of the block are rolled back by the undo log of the tree. In the transactional mode the whole batch is
+ * the transaction, so the failed batch leaves the tree as it was before the run.
  */
 class FileManagerEmulator final
 {
-    public:
-        /**
-         * \brief FsNode represents a single node (file or directory).
-         */
-        struct FsNode final
-        {
-            /**
-             * \brief Creates a deep copy of this node and its children.
-             * 
-             * \param newName Optional new name for the root of the copied subtree.
-             * \return A unique_ptr to the new node.
-             */
-            std::unique_ptr<FsNode> copy(std::string_view newName = "") const;
-
-            std::string                                              name;
-            bool                                                     isDirectory = true;
-            std::unordered_map<std::string, std::unique_ptr<FsNode>> children;
-        };
-
-        /**
-         * \brief NodeTransferMode defines whether a node is copied or moved between directories.
-         */
-        enum class NodeTransferMode
-        {
-            Copy,
-            Move
-        };
-
-        /**
-         * \brief NodeType defines the type of node.
-         */
-        enum class NodeType
-        {
-            Directory,
-            File,
-            Invalid
-        };
-
-        /**
-         * \brief PathInfo decomposes a normalized absolute path into components.
-         */
-        struct PathInfo
-        {
-            std::string path;
-            std::string basename;
-            NodeType    type;  /// A "rough" guess about the file type based on the presence of '.',
-                               /// since dirs can also have '.' in their names.
-        };
-
     public:
         /**
          * \brief Constructs a FileManagerEmulator instance.
@@ -100,23 +76,143 @@ class FileManagerEmulator final
         FileManagerEmulator& operator=(const FileManagerEmulator&) = delete;
         FileManagerEmulator& operator=(FileManagerEmulator&&)      = delete;
 
+        /**
+         * \brief Returns the usage statistics of the allocator of the directories contents.
+         */
+        const SlabAllocator::Statistics& directoryAllocatorStatistics() const;
+        /**
+         * \brief Returns the usage statistics of the allocator of the virtual file tree nodes.
+         */
+        const SlabAllocator::Statistics& nodeAllocatorStatistics() const;
+        /**
+         * \brief Replaces the file tree with the tree from the binary snapshot.
+         *
+         * Regular files are memory-mapped, so the tree is built directly from the snapshot without parsing.
+         *
+         * \return false if the snapshot cannot be read or it is invalid (the current tree isn't changed).
+         */
+        bool                             loadSnapshot(std::string_view snapshotPath);
+        /**
+         * \brief Returns the memory usage of the virtual file tree (walks the tree).
+         */
+        FsTree::MemoryUsage              memoryUsage() const;
+        /**
+         * \brief Returns the latencies of the commands and the counters of the hot paths.
+         *
+         * The node counters are taken from the node allocator, so they are available even if the collection
+         * of the metrics is disabled.
+         */
+        Metrics                          metrics() const;
+        /**
+         * \brief Starts journaling of the successfully executed commands.
+         *
+         * On resume the tree is restored from the last checkpoint and the journal after it, the restored commands
+         * are skipped in the input of the next run(), so a failed run can be continued with the fixed batch file.
+         * Without a checkpoint the journal is replayed on the current tree (for example, the loaded snapshot).
+         *
+         * \param journalPath The path of the journal, the checkpoint is stored next to it.
+         * \param checkpointInterval The number of the journaled commands between the checkpoints (0 disables them).
+         * \param resume If false, the previous journal and checkpoint are discarded.
+         * \return false if the journal cannot be opened or the state cannot be restored.
+         */
+        bool                             openJournal(std::string_view journalPath, std::size_t checkpointInterval,
+                                                     bool resume);
+        /**
+         * \brief Returns the hit/miss statistics of the cache of the resolved paths.
+         */
+        const PathCache::Statistics&     pathCacheStatistics() const;
         /**
          * \brief Prints the current virtual file tree in human-readable form
          * organized in alphabetical ascending order.
          */
-        void      printFileTree() const;
+        void                             printFileTree() const;
+        /**
+         * \brief Prints the items added and removed since the start of the current run with their ancestors.
+         *
+         * The shared contents are unchanged, so only the changed directories are walked.
+         */
+        void                             printFileTreeChanges() const;
         /**
          * \brief Runs a batch command file or reads commands from stdin.
          * 
          * \param batchFilePath Path to the batch file (empty string means stdin).
          * \return ErrorCode representing execution result.
          */
-        ErrorCode run(std::string_view batchFilePath = "");
+        ErrorCode                        run(std::string_view batchFilePath = "");
+        /**
+         * \brief Runs the commands from the memory as a batch file (the commands are logged before execution).
+         *
+         * \param commands The text of the batch, it must be valid until the end of the run.
+         * \return ErrorCode representing execution result.
+         */
+        ErrorCode                        runCommands(std::string_view commands);
+        /**
+         * \brief Saves the file tree into the binary snapshot, which can be loaded by loadSnapshot().
+         */
+        bool                             saveSnapshot(std::string_view snapshotPath) const;
+        /**
+         * \brief Enables the fast exit: the destructor doesn't free the file tree.
+         *
+         * The memory is returned to the system by the process exit, so the emulator must be destroyed
+         * only right before the exit.
+         */
+        void                             setFastExit(bool fastExit);
+        /**
+         * \brief Enables the collection of the latencies and the counters (disabled by default).
+         *
+         * The parsing time is measured only for the batch files executed without the pipeline.
+         * It has no effect if the metrics are disabled at compile time.
+         */
+        void                             setMetricsEnabled(bool enabled);
+        /**
+         * \brief Enables the pipelined execution of the batch files.
+         *
+         * The commands are parsed ahead on the separate thread and executed on the calling thread in the same order.
+         * Standard input is always read on the calling thread.
+         */
+        void                             setPipelined(bool pipelined);
+        /**
+         * \brief Sets the number of the cached resolved paths (0 disables the cache).
+         */
+        void                             setPathCacheCapacity(std::size_t capacity);
+        /**
+         * \brief Enables the machine-readable result of every command: the line "RESULT: <error code>".
+         *
+         * The result of du is followed by the numbers of the files and directories and the depth of the subtree.
+         * The result lines are written regardless of the level of the log.
+         */
+        void                             setResultLines(bool resultLines);
+        /**
+         * \brief Enables the transactional execution: the failed batch is rolled back (disabled by default).
+         *
+         * The commands of the batch are journaled only when it succeeds.
+         */
+        void                             setTransactional(bool transactional);
+        /**
+         * \brief Sets how the file tree is printed after the execution (the whole tree by default).
+         */
+        void                             setTreeOutput(TreeOutput treeOutput);
+        /**
+         * \brief Returns the tree, its operations don't log anything and return the structured results.
+         */
+        FsTree&                          tree() noexcept;
 
+        /**
+         * \brief Starts the transaction block, it can be nested into another one.
+         */
+        bool begin();
+        /**
+         * \brief Commits the innermost transaction block (the outer transaction can still roll it back).
+         */
+        bool commit();
         /**
          * \brief Copies a file or directory (recursively) to a new location.
          */
         bool cp(std::string_view source, std::string_view destination);
+        /**
+         * \brief Logs the numbers of the files and directories under the item and the depth of its subtree.
+         */
+        bool du(std::string_view path);
         /**
          * \brief Creates a new directory at the given absolute path.
          */
@@ -140,72 +236,84 @@ class FileManagerEmulator final
          */
         ErrorCode   executeCommand(const Command& command);
         /**
-         * \brief Finds a node by normalized absolute path. Returns nullptr if not found or on errors.
+         * \brief Finishes the transactions of the run: commits the batch or rolls back the failed one.
+         *
+         * \return The code of the run, the unterminated transaction block is the logic error.
          */
-        FsNode*     findNodeByPath(std::string_view normalizedNodePath) const;
+        ErrorCode   finishTransactions(ErrorCode code);
         /**
-         * \brief Initializes command parser from batch file or standard input.
+         * \brief Appends the executed command to the journal, the commands of the transaction wait for its commit.
          */
-        bool        initCommandParser(std::string_view batchFilePath);
+        bool        journalCommand(std::string_view commandString);
         /**
-         * \brief Checks if the given path/basename combination represents the root directory.
+         * \brief Appends the commands (one per line) to the journal and writes the checkpoint when it is due.
          */
-        bool        isRootDirectory(std::string_view path, std::string_view basename) const;
+        bool        journalCommands(std::string_view commands);
         /**
-         * \brief Returns a child node by name. Returns nullptr on errors.
+         * \brief Reports the parsing errors of the command or executes it.
+         *
+         * \param logCommand If true, the command is logged before execution.
+         * \return ErrorCode::NoError if the execution can be continued.
          */
-        FsNode*     getChildNode(const FsNode* node, const std::string& childName,
-                                 std::string_view normalizedNodePath) const;
+        ErrorCode   processCommand(const Command& command, bool logCommand);
         /**
-         * \brief Splits normalized absolute path into components and infers node type.
+         * \brief Adds the time elapsed since the start to the histogram of the command phase.
          */
-        PathInfo    getNodePathInfo(std::string_view normalizedNodeAbsolutePath,
-                                    NodeType         requiredNodeType = NodeType::Invalid) const;
+        void        recordLatency(CommandName name, CommandPhase phase, std::chrono::steady_clock::time_point start);
         /**
-         * \brief Normalizes a given path: trims components and merges redundant delimiters.
-         */                           
-        std::string normalizePath(std::string_view path) const;
+         * \brief Restores the tree from the checkpoint and the journal.
+         */
+        bool        resumeJournal();
         /**
-         * \brief Transfers (copies/moves) node between directories.
-         * 
-         * \param requiredNodeType Type of transfered node.
-         * \param parentS The parent node of the source node.
-         * \param parentD The parent node of the destination node.
-         * \param source The absolute path of the source.
-         * \param destination The absolute path of the destination.
-         * \param basenameS The name of the source node.
-         * \param basenameD The name of the destination node.
-         * \param pathD The path to the destination node without name of the file/directory.
-         * \param ignoreIfAlreadyExist If true, the operation succeeds silently when a node with the same name
-         * already exists in the target directory. If false, an existing node at the target path causes the operation to fail.
-         * \param transferMode Marks how to handle the source node during transfer (Copy - don't touch, Move - remove).
-         */
-        bool        transferNode(NodeType requiredNodeType, FileManagerEmulator::FsNode* parentS,
-                                 FileManagerEmulator::FsNode* parentD, std::string_view source, std::string_view destination,
-                                 const std::string& basenameS, const std::string& basenameD, std::string_view pathD,
-                                 bool ignoreIfAlreadyExist, NodeTransferMode transferMode);
-        /**
-         * \brief Validates and performs node creation.
-         * 
-         * \see transferNode() for details about parameters.
+         * \brief Initializes the parser by the callback and executes its commands, then prints the tree.
          */
-        bool        validateAndCreateNode(NodeType requiredNodeType, std::string_view nodePath,
-                                          bool ignoreIfAlreadyExist);
+        ErrorCode   runParser(const std::function<bool()>& initParser);
         /**
-         * \brief Validates and performs a move/copy operation between paths.
+         * \brief Executes the commands, which are parsed on the separate thread, until the first error.
          */
-        bool        validateAndTransferNode(std::string_view source, std::string_view destination,
-                                            NodeTransferMode transferMode);
+        ErrorCode   runPipelined(bool logCommands);
+        /**
+         * \brief Initializes command parser from batch file or standard input.
+         *
+         * Regular batch files are memory-mapped, other batch files and standard input are read via the stream.
+         */
+        bool        initCommandParser(std::string_view batchFilePath);
+        /**
+         * \brief Logs the result of the operation of the tree.
+         *
+         * \return true if the operation succeeded.
+         */
+        bool        logResult(CommandName name, const FsResult& result);
         /**
          * \brief Validates number of arguments for a command.
          */
         bool        validateNumberOfCommandArguments(const Command& command) const;
+        /**
+         * \brief Writes the result line of the executed command if the result lines are enabled.
+         */
+        void        writeResultLine(const Command& command, ErrorCode code);
 
     private:
-        std::unique_ptr<Logger>        m_logger;
-        std::ifstream                  m_fileInStream;
-        std::unique_ptr<FsNode>        m_fsRoot;
-        std::unique_ptr<CommandParser> m_parser;
+        std::unique_ptr<Logger>         m_logger;
+        std::unique_ptr<MappedFile>     m_batchFile;
+        std::ifstream                   m_fileInStream;
+        FsTree                          m_tree;  // The removed subtrees are reclaimed between the commands
+        bool                            m_pipelined   = false;
+        bool                            m_readsMemory = false;  // The parser reads the mapped file or the memory
+        std::unique_ptr<CommandParser>  m_parser;
+        std::unique_ptr<CommandJournal> m_journal;
+        std::size_t                     m_checkpointInterval      = 0;
+        std::size_t                     m_commandsSinceCheckpoint = 0;
+        std::uint64_t                   m_skippedCommandsNumber   = 0;  // The commands restored from the journal
+        Metrics                         m_metrics;
+        bool                            m_collectMetrics = false;
+        TreeOutput                      m_treeOutput     = TreeOutput::Full;
+        bool                            m_transactional    = false;
+        bool                            m_batchTransaction = false;  // The run is the outermost transaction
+        std::string                     m_transactionCommands;       // The commands waiting for the commit
+        bool                            m_resultLines = false;
+        std::string                     m_resultLine;
+        FsSubtreeStats                  m_duStats;  // The result of the last du for the result line
 };
 
 #endif  // FILE_MANAGER_EMULATOR_H
@@ -0,0 +1,103 @@
+#ifndef FME_METRICS_H
+#define FME_METRICS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "command_type.h"
+
+#ifndef FME_METRICS_ENABLED
+#    define FME_METRICS_ENABLED 0
+#endif
+
+/// The metrics are collected only if they are enabled at compile time (the FME_METRICS option of CMake).
+constexpr inline bool metricsEnabled = FME_METRICS_ENABLED != 0;
+
+/**
+ * \brief Returns the current time for the metrics, without reading the clock if the metrics are disabled.
+ */
+inline std::chrono::steady_clock::time_point metricsNow() noexcept
+{
+    if constexpr (metricsEnabled)
+    {
+        return std::chrono::steady_clock::now();
+    }
+    else
+    {
+        return {};
+    }
+}
+
+/**
+ * \brief LatencyHistogram counts the durations in the buckets of the power-of-two nanoseconds.
+ *
+ * Adding of a duration takes constant time and never allocates, the percentiles are the upper bounds
+ * of the buckets.
+ */
+class LatencyHistogram final
+{
+    public:
+        static constexpr std::size_t bucketsNumber = 48;
+
+        /// Adds the duration.
+        void                     add(std::chrono::nanoseconds duration) noexcept;
+        /// Returns the number of the added durations.
+        std::uint64_t            count() const noexcept;
+        /// Returns the maximum added duration.
+        std::chrono::nanoseconds max() const noexcept;
+        /// Returns the mean of the added durations.
+        std::chrono::nanoseconds mean() const noexcept;
+        /// Returns the upper bound of the bucket, which contains the percentile (0 < percentile <= 100).
+        std::chrono::nanoseconds percentile(double percentile) const noexcept;
+        /// Returns the sum of the added durations.
+        std::chrono::nanoseconds total() const noexcept;
+
+    private:
+        std::array<std::uint64_t, bucketsNumber> m_buckets = {};  // Bucket i counts durations below 2^i ns
+        std::uint64_t                            m_count   = 0;
+        std::chrono::nanoseconds                 m_total   = {};
+        std::chrono::nanoseconds                 m_max     = {};
+};
+
+/**
+ * \brief CommandPhase defines the part of the command handling measured by the histogram.
+ */
+enum class CommandPhase
+{
+    Parse,    /// Reading and parsing of the command.
+    Execute,  /// Execution of the command without its logging.
+    Log       /// Formatting and writing of the log messages of the command.
+};
+
+/**
+ * \brief Metrics are the latencies of the commands and the counters of the hot paths of the emulator.
+ */
+struct Metrics final
+{
+        static constexpr std::size_t commandNamesNumber = static_cast<std::size_t>(CommandName::Unknown) + 1;
+        static constexpr std::size_t phasesNumber       = static_cast<std::size_t>(CommandPhase::Log) + 1;
+
+        /// The latencies by the command name and the phase.
+        std::array<std::array<LatencyHistogram, phasesNumber>, commandNamesNumber> latencies;
+
+        std::uint64_t nodesAllocated         = 0;
+        std::uint64_t nodesFreed             = 0;
+        std::uint64_t peakNodes              = 0;  /// The peak number of the nodes (the peak tree size).
+        std::uint64_t pathComponentsResolved = 0;  /// The path components walked from the root or from the base.
+        std::uint64_t childrenLookups        = 0;  /// The lookups of the children by name (including the components).
+        std::uint64_t bytesLogged            = 0;
+
+        /// Returns the histogram of the command name and the phase.
+        LatencyHistogram&       latency(CommandName name, CommandPhase phase) noexcept;
+        const LatencyHistogram& latency(CommandName name, CommandPhase phase) const noexcept;
+};
+
+/**
+ * \brief Writes the table of the latencies and the counters in human-readable form.
+ */
+void writeMetricsReport(const Metrics& metrics, std::ostream& output);
+
+#endif  // FME_METRICS_H
@@ -0,0 +1,88 @@
+#ifndef FS_NAME_H
+#define FS_NAME_H
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * \brief FsName is the compact name of a node: the short names are stored inline, the long ones are shared.
+ *
+ * The name takes 16 bytes. The names up to maxInlineSize bytes (almost all names of the trees) are stored inline
+ * without allocation. A longer name is allocated once and its copies (the copies of the node, the clones of
+ * the shared contents) share it by the counted reference. The spare bits of the name keep the flags of the owner,
+ * so the owner doesn't need the padded fields for them.
+ *
+ * The counter isn't atomic, so the copies of the name must be used by one thread (as the nodes of a tree).
+ */
+class FsName final
+{
+    public:
+        static constexpr std::size_t maxInlineSize = 15;
+        static constexpr std::size_t flagsNumber   = 2;  /// The number of the flags of the owner.
+
+        FsName() noexcept = default;
+        explicit FsName(std::string_view name);
+        FsName(const FsName& other) noexcept;
+        FsName(FsName&& other) noexcept;
+
+        ~FsName();
+
+        FsName& operator=(FsName other) noexcept;
+        /**
+         * \brief Replaces the name, the flags are kept.
+         */
+        FsName& operator=(std::string_view name);
+
+        operator std::string_view() const noexcept;
+
+        friend bool                 operator==(const FsName& a, const FsName& b) noexcept;
+        friend bool                 operator==(const FsName& a, std::string_view b) noexcept;
+        friend std::strong_ordering operator<=>(const FsName& a, const FsName& b) noexcept;
+        friend std::strong_ordering operator<=>(const FsName& a, std::string_view b) noexcept;
+
+        const char* data() const noexcept;
+        bool        empty() const noexcept;
+        /**
+         * \brief Returns the flag of the owner by its index (less than flagsNumber).
+         */
+        bool        flag(std::size_t index) const noexcept;
+        /**
+         * \brief Returns the address of the allocated name or nullptr for the inline name (the copies share it).
+         */
+        const void* heapData() const noexcept;
+        /**
+         * \brief Returns the number of the allocated bytes of the long name (0 for the inline name).
+         */
+        std::size_t heapSize() const noexcept;
+        void        setFlag(std::size_t index, bool value) noexcept;
+        std::size_t size() const noexcept;
+        std::string_view view() const noexcept;
+
+    private:
+        /**
+         * \brief LongName is the header of the allocated name, the characters follow it.
+         */
+        struct LongName
+        {
+                std::uint32_t refCount = 1;
+                std::uint32_t size     = 0;
+        };
+
+        static constexpr std::uint8_t sizeMask   = 0x0F;  // The size of the inline name
+        static constexpr std::uint8_t longBit    = 0x10;
+        static constexpr std::uint8_t flagsShift = 6;
+
+        LongName* longName() const noexcept;
+        void      release() noexcept;
+
+    private:
+        alignas(LongName*) std::array<char, maxInlineSize> m_chars = {};  // Or the pointer to the LongName
+        std::uint8_t                                       m_tag   = 0;   // The size or longBit and the flags
+};
+
+static_assert(sizeof(FsName) == 16);
+
+#endif  // FS_NAME_H
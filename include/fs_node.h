@@ -0,0 +1,373 @@
+#ifndef FS_NODE_H
+#define FS_NODE_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "fs_name.h"
+#include "slab_allocator.h"
+
+struct FsDirectory;
+struct FsNode;
+class FsNodeStorage;
+
+/**
+ * \brief FsNodeDeleter destroys the node and returns its memory into the node allocator.
+ */
+struct FsNodeDeleter final
+{
+        void operator()(FsNode* node) const noexcept;
+
+        SlabAllocator* allocator = nullptr;
+};
+
+/**
+ * \brief FsNodePtr owns a node allocated by the FsNodeStorage.
+ */
+using FsNodePtr = std::unique_ptr<FsNode, FsNodeDeleter>;
+
+/**
+ * \brief FsChildren is the container of the children of a directory, ordered by the names of the nodes.
+ *
+ * The children are keyed by their own FsNode::name, so names aren't stored twice.
+ * Small directories keep the children in a sorted vector (binary search, compact and cache-friendly).
+ * When a directory becomes wide, the children are moved into a balanced search tree, so insertion and removal
+ * stay logarithmic. Iteration always visits the children in alphabetical ascending order, so no sorting is needed.
+ *
+ * The name of a node must not be changed while the node is in the container (except by rename()).
+ */
+class FsChildren final
+{
+    private:
+        struct NameLess
+        {
+                using is_transparent = void;
+
+                bool operator()(const FsNodePtr& a, const FsNodePtr& b) const noexcept;
+                bool operator()(const FsNodePtr& a, std::string_view b) const noexcept;
+                bool operator()(std::string_view a, const FsNodePtr& b) const noexcept;
+        };
+
+        using FlatChildren = std::vector<FsNodePtr>;
+        using TreeChildren = std::set<FsNodePtr, NameLess>;
+
+    public:
+        /**
+         * \brief Iterator over the children in alphabetical ascending order.
+         */
+        class const_iterator final
+        {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = FsNodePtr;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const FsNodePtr*;
+                using reference         = const FsNodePtr&;
+
+                const_iterator() = default;
+
+                reference       operator*() const;
+                pointer         operator->() const;
+                const_iterator& operator++();
+                const_iterator  operator++(int);
+                bool            operator==(const const_iterator& other) const = default;
+
+            private:
+                friend class FsChildren;
+
+                using Iterator = std::variant<FlatChildren::const_iterator, TreeChildren::const_iterator>;
+
+                explicit const_iterator(Iterator it);
+
+            private:
+                Iterator m_it;
+        };
+
+    public:
+        const_iterator begin() const noexcept;
+        const_iterator end() const noexcept;
+
+        /**
+         * \brief Returns the child at the position returned by lowerBound() if the child has the name (or nullptr).
+         */
+        FsNode*        childAt(const_iterator position, std::string_view name) const noexcept;
+        /**
+         * \brief Checks whether the directory contains the child with the given name.
+         */
+        bool           contains(std::string_view name) const noexcept;
+        bool           empty() const noexcept;
+        /**
+         * \brief Removes the child with the given name. Returns false if there is no such a child.
+         */
+        bool           erase(std::string_view name);
+        /**
+         * \brief Removes the child with the given name from the container and returns it (or nullptr).
+         */
+        FsNodePtr      extract(std::string_view name);
+        /**
+         * \brief Removes the child at the position from the container and returns it.
+         */
+        FsNodePtr      extract(const_iterator position);
+        /**
+         * \brief Moves all children into the end of the vector, the container becomes empty.
+         */
+        void           extractAll(std::vector<FsNodePtr>& nodes);
+        /**
+         * \brief Returns the child with the given name or nullptr.
+         */
+        FsNode*        find(std::string_view name) const noexcept;
+        /**
+         * \brief Returns the number of the bytes allocated for the children (estimated for the search tree).
+         */
+        std::size_t    heapSize() const noexcept;
+        /**
+         * \brief Inserts the node. Appending of the nodes in ascending order takes the constant time.
+         *
+         * \return The inserted node or nullptr if the directory already contains the child with the same name
+         * (the passed node is destroyed in this case).
+         */
+        FsNode*        insert(FsNodePtr node);
+        /**
+         * \brief Inserts the node at the position returned by lowerBound() for its name, so the name isn't searched
+         * again. The container must not be changed since the lookup and must not contain the name.
+         *
+         * \return The inserted node.
+         */
+        FsNode*        insert(const_iterator position, FsNodePtr node);
+        /**
+         * \brief Returns the position of the child with the name or the position, where such a child is inserted.
+         *
+         * The position stays valid until the container is changed.
+         */
+        const_iterator lowerBound(std::string_view name) const noexcept;
+        /**
+         * \brief Renames the child and moves it from its position to the position returned by lowerBound()
+         * for the new name. The container must not contain the new name.
+         *
+         * Neither the node nor the element of the container is reallocated: the vector is rotated between
+         * the positions, a tree node is extracted and inserted back by its handle.
+         *
+         * \return The renamed node.
+         */
+        FsNode*        rename(const_iterator position, const_iterator newPosition, std::string_view newName);
+        /**
+         * \brief Reserves the memory for the given number of the children (only for small directories).
+         */
+        void           reserve(std::size_t size);
+        std::size_t    size() const noexcept;
+
+    private:
+        /**
+         * \brief Moves children into the suitable representation after the change of the size.
+         */
+        void updateRepresentation();
+
+    private:
+        std::variant<FlatChildren, TreeChildren> m_children;
+};
+
+/**
+ * \brief FsDirectoryRef is a counted reference to the content of a directory.
+ *
+ * Copying of the reference shares the content. The content is destroyed together with the last reference.
+ */
+class FsDirectoryRef final
+{
+    public:
+        FsDirectoryRef() = default;
+        explicit FsDirectoryRef(FsDirectory* directory) noexcept;
+        FsDirectoryRef(const FsDirectoryRef& other) noexcept;
+        FsDirectoryRef(FsDirectoryRef&& other) noexcept;
+
+        ~FsDirectoryRef();
+
+        FsDirectoryRef& operator=(FsDirectoryRef other) noexcept;
+
+        FsDirectory* operator->() const noexcept;
+        explicit     operator bool() const noexcept;
+
+        /**
+         * \brief Returns the pointer to the content of the directory (nullptr for files).
+         */
+        FsDirectory* get() const noexcept;
+        /**
+         * \brief Checks whether the content is referenced by more than one node.
+         */
+        bool         isShared() const noexcept;
+
+    private:
+        FsDirectory* m_directory = nullptr;
+};
+
+/**
+ * \brief FsSubtreeStats are the aggregates of the subtree of a directory.
+ *
+ * The aggregates belong to the content of the directory, so the copies share them together with the content.
+ * They are updated along the ancestors on every insertion and removal of a child, so they are always ready.
+ */
+struct FsSubtreeStats final
+{
+        std::size_t files           = 0;  /// The number of the files in the subtree.
+        std::size_t directories     = 0;  /// The number of the directories in the subtree (without the directory).
+        std::size_t maxDepth        = 0;  /// The depth of the deepest item below the directory (0 if it is empty).
+        std::size_t deepestChildren = 0;  /// The number of the children, whose subtrees reach maxDepth.
+
+        /**
+         * \brief Adds the child with its subtree to the aggregates.
+         */
+        void addChild(const FsNode& child) noexcept;
+};
+
+/**
+ * \brief FsDirectory is the content of a directory, which can be shared by several nodes.
+ *
+ * The content is shared after copying of a directory and it is cloned on the first modification
+ * (copy-on-write). A clone is shallow: it creates new child nodes, which share the contents of the original children.
+ */
+struct FsDirectory final
+{
+        SlabAllocator* allocator = nullptr;  /// The allocator of this object.
+        std::size_t    refCount  = 1;
+        FsChildren     children  = {};
+        FsSubtreeStats stats     = {};
+};
+
+/**
+ * \brief FsNode represents a single node (file or directory).
+ *
+ * The node keeps the link to its parent. A shared content belongs to several directories, so the parent links
+ * of its children refer only to one of them. The links are valid for the nodes, whose ancestors are unshared
+ * (for example, the nodes found for modification): mutableChildren() updates the links of the children.
+ */
+struct FsNode final
+{
+        /**
+         * \brief Inserts the child into the directory and links the child to this node.
+         *
+         * The subtree aggregates of this node and its ancestors are updated, so they must be unshared.
+         *
+         * \return The inserted node or nullptr if the directory already contains the child with the same name.
+         */
+        FsNode*               addChild(FsNodeStorage& storage, FsNodePtr child);
+        /**
+         * \brief Inserts the child at the position returned by lowerBound() of mutableChildren() for its name.
+         *
+         * \see addChild() and FsChildren::insert() for the requirements.
+         */
+        FsNode*               addChild(FsNodeStorage& storage, FsChildren::const_iterator position, FsNodePtr child);
+        /**
+         * \brief Appends the absolute path of the node to the string (see path()).
+         */
+        void                  appendPath(std::string& result) const;
+        /**
+         * \brief Returns the children of the node (always empty for files).
+         */
+        const FsChildren&     children() const noexcept;
+        /**
+         * \brief Creates a copy of this node, which shares the content with this node.
+         *
+         * The subtree isn't copied, so the operation doesn't depend on the size of the subtree.
+         *
+         * \param storage The storage for the new node.
+         * \param newName Optional new name for the root of the copied subtree.
+         * \return A FsNodePtr to the new node.
+         */
+        FsNodePtr             copy(FsNodeStorage& storage, std::string_view newName = "") const;
+        /**
+         * \brief Returns the number of the ancestors of the node (0 for the root). Takes O(depth) time.
+         */
+        std::size_t           depth() const noexcept;
+        /**
+         * \brief Removes the child from the directory and returns it unlinked (or nullptr).
+         *
+         * The subtree aggregates of this node and its ancestors are updated, so they must be unshared.
+         */
+        FsNodePtr             extractChild(FsNodeStorage& storage, std::string_view name);
+        /**
+         * \brief Removes the child at the position in mutableChildren() and returns it unlinked.
+         */
+        FsNodePtr             extractChild(FsNodeStorage& storage, FsChildren::const_iterator position);
+        /**
+         * \brief Checks whether the node is a directory (the flag is kept in the spare bits of the name).
+         */
+        bool                  isDirectory() const noexcept;
+        /**
+         * \brief Checks whether the node is a proper ancestor of the other node. Takes O(depth) time.
+         */
+        bool                  isAncestorOf(const FsNode& node) const noexcept;
+        /**
+         * \brief Returns the children of the directory for modification.
+         *
+         * Clones the content if it is shared with other nodes, so the modification is visible only
+         * via this node. The node itself must not be shared (all its ancestors must be already unshared).
+         */
+        FsChildren&           mutableChildren(FsNodeStorage& storage);
+        /**
+         * \brief Reconstructs the absolute path of the node from the parent links.
+         */
+        std::string           path() const;
+        /**
+         * \brief Returns the aggregates of the subtree of the node (always empty for files). Takes O(1) time.
+         */
+        const FsSubtreeStats& stats() const noexcept;
+
+        /// The flag of the directory node of FsName.
+        static constexpr std::size_t directoryFlag = 0;
+
+        FsName         name;
+        FsDirectoryRef directory;         /// The content of the directory, null for files.
+        FsNode*        parent = nullptr;  /// Null for the root and for the nodes outside of the tree.
+};
+
+static_assert(sizeof(FsNode) == 32, "The nodes are compact: the name, the content and the parent link");
+
+/**
+ * \brief FsNodeStorage provides memory for the nodes and the contents of the directories of a virtual file tree.
+ *
+ * The storage must outlive all nodes created by it.
+ */
+class FsNodeStorage final
+{
+    public:
+        FsNodeStorage();
+        FsNodeStorage(const FsNodeStorage&) = delete;
+        FsNodeStorage(FsNodeStorage&&)      = delete;
+
+        ~FsNodeStorage() = default;
+
+        FsNodeStorage& operator=(const FsNodeStorage&) = delete;
+        FsNodeStorage& operator=(FsNodeStorage&&)      = delete;
+
+        /**
+         * \brief Creates a directory content. The content is not referenced by any node yet.
+         */
+        FsDirectoryRef                   createDirectory();
+        /**
+         * \brief Creates a new node. A directory node gets the new empty content.
+         */
+        FsNodePtr                        createNode(std::string_view name, bool isDirectory);
+        /**
+         * \brief Creates a new node, which references the given content (the copied name shares the long name).
+         */
+        FsNodePtr                        createNode(FsName name, bool isDirectory, FsDirectoryRef directory);
+        /**
+         * \brief Returns the usage statistics of the allocator of the directories contents.
+         */
+        const SlabAllocator::Statistics& directoryAllocatorStatistics() const noexcept;
+        /**
+         * \brief Returns the usage statistics of the allocator of the nodes.
+         */
+        const SlabAllocator::Statistics& nodeAllocatorStatistics() const noexcept;
+
+    private:
+        SlabAllocator m_nodeAllocator;
+        SlabAllocator m_directoryAllocator;
+};
+
+#endif  // FS_NODE_H
@@ -0,0 +1,61 @@
+#ifndef FS_NODE_RECLAIMER_H
+#define FS_NODE_RECLAIMER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "fs_node.h"
+
+/**
+ * \brief FsNodeReclaimer frees detached subtrees incrementally.
+ *
+ * A removed subtree is passed to defer() in O(1) and it is freed later by reclaim() in slices of the bounded size,
+ * so the removal of a huge directory doesn't stall the caller. The subtrees are freed without recursion,
+ * so deep subtrees don't exhaust the stack. A content shared with other nodes is only released,
+ * its children stay alive.
+ *
+ * The reclaimer must be used on the thread, which owns the tree: the contents can be shared with the live nodes.
+ */
+class FsNodeReclaimer final
+{
+    public:
+        FsNodeReclaimer() = default;
+        FsNodeReclaimer(const FsNodeReclaimer&) = delete;
+        FsNodeReclaimer(FsNodeReclaimer&&)      = delete;
+
+        /**
+         * \brief Frees all pending nodes.
+         */
+        ~FsNodeReclaimer();
+
+        FsNodeReclaimer& operator=(const FsNodeReclaimer&) = delete;
+        FsNodeReclaimer& operator=(FsNodeReclaimer&&)      = delete;
+
+        /**
+         * \brief Schedules freeing of the detached subtree.
+         */
+        void        defer(FsNodePtr node);
+        /**
+         * \brief Checks whether there are no pending nodes.
+         */
+        bool        empty() const noexcept;
+        /**
+         * \brief Frees at most maxNodes pending nodes.
+         *
+         * \return The number of the freed nodes.
+         */
+        std::size_t reclaim(std::size_t maxNodes);
+        /**
+         * \brief Frees all pending nodes.
+         */
+        void        reclaimAll();
+        /**
+         * \brief Forgets the pending nodes without freeing them (for example, right before the process exit).
+         */
+        void        release() noexcept;
+
+    private:
+        std::vector<FsNodePtr> m_pendingNodes;
+};
+
+#endif  // FS_NODE_RECLAIMER_H
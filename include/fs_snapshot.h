@@ -0,0 +1,52 @@
+#ifndef FS_SNAPSHOT_H
+#define FS_SNAPSHOT_H
+
+#include <iosfwd>
+#include <string_view>
+
+#include "fs_node.h"
+
+/**
+ * \brief SnapshotError represents possible outcomes of saving and loading of the snapshots.
+ */
+enum class SnapshotError
+{
+    NoError = 0,
+    CannotOpenFile,   /// The snapshot file cannot be opened.
+    CannotWriteFile,  /// Writing of the snapshot failed.
+    InvalidFormat,    /// The data is not a snapshot or it is corrupted.
+    TooLarge          /// The tree doesn't fit into the 32-bit indexes of the format.
+};
+
+/**
+ * \brief Returns the description of the snapshot error.
+ */
+std::string_view snapshotErrorToString(SnapshotError error);
+
+/**
+ * \brief Writes the tree into the binary snapshot.
+ *
+ * The snapshot consists of the header, the flat array of the nodes, the array of the directory contents and
+ * the string table with the names. Every content is the range of the consecutive nodes (its children in
+ * alphabetical ascending order), so the contents shared by several directories are written only once.
+ * The contents are ordered so that a content refers only to the contents with greater indexes.
+ * The numbers are written in the byte order of the machine.
+ *
+ * \param root The root of the tree.
+ * \param output The binary stream for the snapshot.
+ */
+SnapshotError saveSnapshot(const FsNode& root, std::ostream& output);
+
+/**
+ * \brief Builds the tree from the binary snapshot written by saveSnapshot().
+ *
+ * The data is validated, so a corrupted snapshot cannot produce an invalid tree. The shared contents
+ * stay shared after loading.
+ *
+ * \param data The content of the snapshot (for example, the memory-mapped file).
+ * \param storage The storage for the nodes of the tree.
+ * \param root Receives the root of the loaded tree. It isn't changed on errors.
+ */
+SnapshotError loadSnapshot(std::string_view data, FsNodeStorage& storage, FsNodePtr& root);
+
+#endif  // FS_SNAPSHOT_H
@@ -0,0 +1,493 @@
+#ifndef FS_TREE_H
+#define FS_TREE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fs_node.h"
+#include "fs_node_reclaimer.h"
+#include "fs_snapshot.h"
+#include "path_cache.h"
+
+/**
+ * \brief FsError represents the reasons, why an operation of the FsTree fails.
+ */
+enum class FsError
+{
+    NoError = 0,               /// The operation succeeded.
+    InvalidFileReference,      /// The file is referenced with '/' in the end.
+    EmptyBasename,             /// The path has no basename.
+    NotADirectory,             /// The path component is a file.
+    PathNotFound,              /// The directory doesn't contain the path component.
+    NoSuchItem,                /// The removed or the transferred item doesn't exist.
+    NoMatches,                 /// The pattern matches no items.
+    AlreadyExists,             /// The directory already contains the item with such a name.
+    RootTransfer,              /// The root directory cannot be copied or moved.
+    TransferIntoSubdirectory,  /// The item cannot be copied or moved into own subdirectory.
+    DestinationNotADirectory,  /// The parent of the destination is a file.
+    DestinationIsFile          /// The existing destination item is a file, so nothing can be transferred into it.
+};
+
+/**
+ * \brief FsOutcome defines how the successful operation has changed the tree.
+ */
+enum class FsOutcome
+{
+    Done,      /// The tree is changed.
+    Ignored,   /// The file isn't created or transferred, because the item with such a name already exists.
+    Unchanged  /// The item is copied or moved into itself.
+};
+
+/**
+ * \brief FsResult is the structured result of an operation of the FsTree.
+ *
+ * The views refer to the internal buffers of the tree and to the names of the nodes,
+ * so they are valid only until the next operation.
+ */
+struct FsResult
+{
+        FsError          error         = FsError::NoError;
+        FsOutcome        outcome       = FsOutcome::Done;
+        bool             isDirectory   = false;  /// The type of the node of the operation (the guess if it is missing).
+        std::string_view path          = {};  /// The normalized path of the node (the source) or the unresolved path.
+        std::string_view directory     = {};  /// The destination, the parent or the directory without the component.
+        std::string_view component     = {};  /// The offending path component or the name of the resulting node.
+        std::size_t      matchesNumber = 0;   /// The number of the items matched by the pattern of the bulk operation.
+        std::size_t      ignoredNumber = 0;   /// The matched items, which aren't transferred, since they already exist.
+        FsSubtreeStats   stats         = {};  /// The aggregates of the subtree of the inspected node.
+
+        /// Checks whether the operation succeeded.
+        bool ok() const noexcept
+        {
+            return error == FsError::NoError;
+        }
+};
+
+/**
+ * \brief FsTree is the virtual file tree with the operations of the emulator.
+ *
+ * The operations don't log anything, they return FsResult, so the tree can be embedded without paying
+ * for the formatting of the messages. The removed subtrees are freed by reclaim() in bounded slices.
+ *
+ * The changes made inside a transaction are recorded in the undo log, so they can be rolled back in O(changes)
+ * instead of the rebuilding of the tree: the removed subtrees are kept in the log, the moves are moved back.
+ */
+class FsTree final
+{
+    public:
+        /**
+         * \brief NodeAccess defines whether a found node is going to be modified.
+         */
+        enum class NodeAccess
+        {
+            Modify,   /// Shared contents along the path are cloned, so the node can be modified.
+            ReadOnly  /// The node and its ancestors are not modified.
+        };
+
+        /**
+         * \brief NodeTransferMode defines whether a node is copied or moved between directories.
+         */
+        enum class NodeTransferMode
+        {
+            Copy,
+            Move
+        };
+
+        /**
+         * \brief NodeType defines the type of node.
+         */
+        enum class NodeType
+        {
+            Directory,
+            File,
+            Invalid
+        };
+
+        /**
+         * \brief PathInfo decomposes a normalized absolute path into components.
+         *
+         * The components are views into the normalized path, which is stored in the buffer passed to parsePath().
+         */
+        struct PathInfo
+        {
+            std::string_view normalizedPath;
+            std::string_view path;      /// The parent path (without the trailing '/').
+            std::string_view basename;  /// Ends with '/' if the type is Invalid.
+            NodeType         type;      /// A "rough" guess about the file type based on the presence of '.',
+                                        /// since dirs can also have '.' in their names.
+        };
+
+        /**
+         * \brief LookupStatistics counts the lookups of the children (only if the counting is enabled).
+         */
+        struct LookupStatistics
+        {
+            std::uint64_t pathComponentsResolved = 0;  /// The path components walked from the root or from the base.
+            std::uint64_t childrenLookups        = 0;  /// The lookups of the children by name.
+        };
+
+        /**
+         * \brief MemoryUsage is the memory of the tree: the shared contents and names are counted once.
+         */
+        struct MemoryUsage
+        {
+            std::size_t nodes          = 0;
+            std::size_t nodeBytes      = 0;
+            std::size_t directories    = 0;  /// The number of the contents of the directories.
+            std::size_t directoryBytes = 0;
+            std::size_t childrenBytes  = 0;  /// The memory of the containers of the children (estimated for sets).
+            std::size_t longNames      = 0;  /// The number of the allocated names (the inline names take nothing).
+            std::size_t nameBytes      = 0;
+
+            /// Returns the memory of the tree.
+            std::size_t totalBytes() const noexcept
+            {
+                return nodeBytes + directoryBytes + childrenBytes + nameBytes;
+            }
+        };
+
+    public:
+        /**
+         * \brief Constructs the tree with the empty root directory.
+         */
+        FsTree();
+        FsTree(const FsTree&) = delete;
+        FsTree(FsTree&&)      = delete;
+
+        /**
+         * \brief Frees the tree, unless the fast exit is enabled.
+         */
+        ~FsTree();
+
+        FsTree& operator=(const FsTree&) = delete;
+        FsTree& operator=(FsTree&&)      = delete;
+
+        /**
+         * \brief Returns the tree kept by keepBaseline() or nullptr.
+         */
+        const FsNode*                    baseline() const noexcept;
+        /**
+         * \brief Starts the transaction: the following changes can be rolled back by rollbackTransaction().
+         *
+         * The transactions can be nested, the changes of a committed nested transaction belong to the outer one.
+         */
+        void                             beginTransaction();
+        /**
+         * \brief Commits the innermost transaction, the subtrees removed in the outermost one are freed by reclaim().
+         *
+         * \return The number of the changes made in the transaction.
+         */
+        std::size_t                      commitTransaction();
+        /**
+         * \brief Returns the usage statistics of the allocator of the directories contents.
+         */
+        const SlabAllocator::Statistics& directoryAllocatorStatistics() const;
+        /**
+         * \brief Frees the baseline by reclaim().
+         */
+        void                             dropBaseline();
+        /**
+         * \brief Keeps the current tree as the baseline of the next changes in O(1).
+         *
+         * The baseline shares the contents with the tree, so a directory is cloned (only its own level) on its first
+         * change. The contents of the unchanged directories stay shared, so comparing of the contents of the tree
+         * and the baseline finds the changed directories without walking the unchanged subtrees.
+         */
+        void                             keepBaseline();
+        /**
+         * \brief Replaces the tree with the tree from the binary snapshot (the tree isn't changed on errors).
+         */
+        SnapshotError                    loadSnapshot(std::string_view data);
+        /**
+         * \brief Returns the lookup counters.
+         */
+        const LookupStatistics&          lookupStatistics() const noexcept;
+        /**
+         * \brief Walks the tree and returns its memory usage (the baseline and the removed subtrees aren't counted).
+         */
+        MemoryUsage                      memoryUsage() const;
+        /**
+         * \brief Returns the usage statistics of the allocator of the virtual file tree nodes.
+         */
+        const SlabAllocator::Statistics& nodeAllocatorStatistics() const;
+        /**
+         * \brief Returns the hit/miss statistics of the cache of the resolved paths.
+         */
+        const PathCache::Statistics&     pathCacheStatistics() const;
+        /**
+         * \brief Frees at most maxNodes nodes of the removed subtrees.
+         *
+         * \return The number of the freed nodes.
+         */
+        std::size_t                      reclaim(std::size_t maxNodes);
+        /**
+         * \brief Replaces the tree with the tree built in storage(), the old tree is freed by reclaim().
+         *
+         * The open transactions are ended without the rollback, since their undo log refers to the old tree.
+         */
+        void                             replaceRoot(FsNodePtr root);
+        /**
+         * \brief Undoes the changes of the innermost transaction in the reverse order and ends it.
+         *
+         * The tree becomes equal to the tree at the start of the transaction, the removed subtrees are inserted back.
+         *
+         * \return The number of the undone changes.
+         */
+        std::size_t                      rollbackTransaction();
+        /**
+         * \brief Returns the root directory.
+         */
+        const FsNode&                    root() const noexcept;
+        /**
+         * \brief Saves the tree into the binary snapshot, which can be loaded by loadSnapshot().
+         */
+        SnapshotError                    saveSnapshot(std::ostream& output) const;
+        /**
+         * \brief Enables the counting of the lookups of the children (disabled by default).
+         *
+         * It has no effect if the metrics are disabled at compile time.
+         */
+        void                             setCountLookups(bool countLookups) noexcept;
+        /**
+         * \brief Enables the fast exit: the destructor doesn't free the tree.
+         *
+         * The memory is returned to the system by the process exit, so the tree must be destroyed
+         * only right before the exit.
+         */
+        void                             setFastExit(bool fastExit) noexcept;
+        /**
+         * \brief Sets the number of the cached resolved paths (0 disables the cache).
+         */
+        void                             setPathCacheCapacity(std::size_t capacity);
+        /**
+         * \brief Returns the storage of the nodes of the tree.
+         */
+        FsNodeStorage&                   storage() noexcept;
+        /**
+         * \brief Returns the number of the open nested transactions (0 outside of the transactions).
+         */
+        std::size_t                      transactionDepth() const noexcept;
+
+        /**
+         * \brief Copies a file or directory (recursively) to a new location.
+         */
+        FsResult cp(std::string_view source, std::string_view destination);
+        /**
+         * \brief Copies all items matched by the pattern into the existing destination directory.
+         *
+         * The pattern is matched in one walk of the tree: '*' and '?' match the characters of one component,
+         * the component "**" matches any number of the directories. The items inside the matched directories
+         * are not matched, the pattern with '/' in the end matches only the directories. The files, which already
+         * exist in the destination, are ignored. Nothing is changed, if a directory cannot be transferred.
+         */
+        FsResult cpMatching(std::string_view pattern, std::string_view destination);
+        /**
+         * \brief Returns the numbers of the files and directories under the item and the depth of its subtree.
+         *
+         * The answer is taken from the aggregates, which are maintained by the changes, so the subtree isn't walked.
+         */
+        FsResult du(std::string_view path);
+        /**
+         * \brief Creates a new directory.
+         */
+        FsResult md(std::string_view dirAbsolutePath);
+        /**
+         * \brief Creates a new file, the existing file is ignored.
+         */
+        FsResult mf(std::string_view fileAbsolutePath);
+        /**
+         * \brief Moves a file or directory to a new location.
+         */
+        FsResult mv(std::string_view source, std::string_view destination);
+        /**
+         * \brief Moves all items matched by the pattern into the existing destination directory.
+         *
+         * \see cpMatching() for details about the pattern.
+         */
+        FsResult mvMatching(std::string_view pattern, std::string_view destination);
+        /**
+         * \brief Removes a file or directory (recursively).
+         */
+        FsResult rm(std::string_view path);
+        /**
+         * \brief Removes all items matched by the pattern.
+         *
+         * \see cpMatching() for details about the pattern.
+         */
+        FsResult rmMatching(std::string_view pattern);
+
+    private:
+        /**
+         * \brief UndoAction is the inverse of the change recorded in the undo log.
+         */
+        enum class UndoAction
+        {
+            Remove,  /// The item is created (md, mf, cp), it is removed.
+            Insert,  /// The subtree is removed (rm), it is inserted back.
+            Move     /// The item is moved or renamed (mv), it is moved back.
+        };
+
+        /**
+         * \brief UndoRecord is the compact inverse of one change made in the transaction.
+         *
+         * The changed items are referred by the paths of their parents and their names, since the nodes of
+         * a directory are replaced, when its content is shared and cloned later in the transaction. The strings
+         * are stored one after another in m_undoPaths, the last record refers to the end of the buffer.
+         */
+        struct UndoRecord
+        {
+                UndoAction                   action;
+                std::array<std::uint32_t, 4> sizes = {};  /// The parent path and the name, for Move the original ones.
+                FsNodePtr                    node  = {};  /// The removed subtree for Insert.
+        };
+
+        /**
+         * \brief GlobMatch is the item matched by the pattern.
+         */
+        struct GlobMatch
+        {
+                std::string path    = {};       /// The normalized path of the item.
+                FsNode*     node    = nullptr;  /// The item found for reading (it can be shared).
+                bool        ignored = false;    /// The item isn't transferred.
+        };
+
+    private:
+        /**
+         * \brief Finds the items matched by the normalized pattern into m_matches in one walk of the tree.
+         *
+         * The matches are ordered by the paths, so a directory precedes its subtree and the items inside
+         * the other matches are dropped.
+         */
+        void     collectMatches(std::string_view normalizedPattern);
+        /**
+         * \brief Counts the lookup of the child by name (and the resolved path component).
+         */
+        void     countChildrenLookup(bool isPathComponent) noexcept;
+        /**
+         * \brief Passes the subtrees of the undo log to the reclaimer and clears the log.
+         */
+        void     dropUndoLog();
+        /**
+         * \brief Finds a node by normalized absolute path. Returns nullptr if not found and sets the error.
+         *
+         * The nodes found for modification are cached, since all their ancestors are unshared, the cached nodes
+         * can be modified without the walk from the root. The cache is invalidated, when any node can be removed,
+         * moved or shared.
+         *
+         * \param access Modify if the found node (and its children) is going to be changed.
+         */
+        FsNode*  findNodeByPath(std::string_view normalizedNodePath, FsResult& result,
+                                NodeAccess access = NodeAccess::Modify);
+        /**
+         * \brief Finds a node for modification by normalized absolute path starting from the other found node.
+         *
+         * The search climbs from the base node to the common ancestor via the parent links and descends from it,
+         * so the common part of the paths isn't walked again.
+         *
+         * \param base The node found for modification (so its parent links are valid).
+         * \param basePath The normalized absolute path of the base node.
+         */
+        FsNode*  findNodeByPath(std::string_view normalizedNodePath, FsNode* base, std::string_view basePath,
+                                FsResult& result);
+        /**
+         * \brief Returns a child node by name. Returns nullptr if not found and sets the error.
+         *
+         * \param access Modify if the child is going to be changed (the content of the node is unshared).
+         */
+        FsNode*  getChildNode(FsNode* node, std::string_view childName, std::string_view normalizedNodePath,
+                              NodeAccess access, FsResult& result);
+        /**
+         * \brief Checks if the given path/basename combination represents the root directory.
+         */
+        bool     isRootDirectory(std::string_view path, std::string_view basename) const;
+        /**
+         * \brief Keeps the subtree removed from the parent in the undo log inside the transaction, otherwise
+         * passes it to the reclaimer.
+         */
+        void     keepRemoved(const FsNode& parent, FsNodePtr subtree);
+        /**
+         * \brief Normalizes a given path and splits it into components in one pass.
+         *
+         * The components are trimmed and redundant delimiters are merged, the node type is inferred.
+         *
+         * \param buffer The storage of the normalized path. Its memory is reused, so parsing usually doesn't allocate.
+         */
+        PathInfo parsePath(std::string_view path, std::string& buffer,
+                           NodeType requiredNodeType = NodeType::Invalid) const;
+        /**
+         * \brief Records the creation of the item inside the transaction.
+         */
+        void     recordCreated(const FsNode& parent, std::string_view name);
+        /**
+         * \brief Records the move of the item inside the transaction.
+         */
+        void     recordMoved(const FsNode& parent, std::string_view name, const FsNode& originalParent,
+                             std::string_view originalName);
+        /**
+         * \brief Transfers (copies/moves) node between directories.
+         *
+         * \param isDirectory Type of transfered node.
+         * \param parentS The parent node of the source node.
+         * \param positionS The position of the source node in the children of parentS.
+         * \param parentD The parent node of the destination node.
+         * \param positionD The position of the name after the transfer in the children of parentD.
+         * \param source The absolute path of the source.
+         * \param destination The absolute path of the destination.
+         * \param basenameS The name of the source node.
+         * \param basenameD The name of the destination node.
+         * \param pathD The path to the destination node without name of the file/directory.
+         * \param ignoreIfAlreadyExist If true, the operation succeeds silently when a node with the same name
+         * already exists in the target directory. If false, an existing node at the target path causes the operation to fail.
+         * \param transferMode Marks how to handle the source node during transfer (Copy - don't touch, Move - remove).
+         */
+        FsResult transferNode(bool isDirectory, FsNode* parentS, FsChildren::const_iterator positionS,
+                              FsNode* parentD, FsChildren::const_iterator positionD, std::string_view source,
+                              std::string_view destination, std::string_view basenameS, std::string_view basenameD,
+                              std::string_view pathD, bool ignoreIfAlreadyExist, NodeTransferMode transferMode);
+        /**
+         * \brief Transfers (copies/moves) all items matched by the pattern into the destination directory.
+         */
+        FsResult transferMatching(std::string_view pattern, std::string_view destination,
+                                  NodeTransferMode transferMode);
+        /**
+         * \brief Unshares the children of the directory for modification and keeps the position of the name in them.
+         *
+         * The position is found again only if the shared children are cloned.
+         */
+        void     unshareChildren(FsNode& directory, FsChildren::const_iterator& position, std::string_view name);
+        /**
+         * \brief Validates and performs node creation.
+         *
+         * \see transferNode() for details about parameters.
+         */
+        FsResult validateAndCreateNode(NodeType requiredNodeType, std::string_view nodePath, bool ignoreIfAlreadyExist);
+        /**
+         * \brief Validates and performs a move/copy operation between paths.
+         */
+        FsResult validateAndTransferNode(std::string_view source, std::string_view destination,
+                                         NodeTransferMode transferMode);
+
+    private:
+        std::unique_ptr<FsNodeStorage> m_nodeStorage;  // Must outlive m_root and m_reclaimer
+        FsNodePtr                      m_root;
+        FsNodePtr                      m_baseline;  // Shares the unchanged contents with m_root
+        FsNodeReclaimer                m_reclaimer;  // Frees the removed subtrees in slices
+        PathCache                      m_pathCache;  // Refers to the nodes of m_root
+        std::string                    m_sourcePathBuffer;
+        std::string                    m_destinationPathBuffer;
+        std::vector<GlobMatch>         m_matches;  // The matches of the last bulk operation
+        std::vector<UndoRecord>        m_undoLog;
+        std::string                    m_undoPaths;     // The strings of the undo records
+        std::vector<std::size_t>       m_transactions;  // The sizes of the undo log at the starts of the transactions
+        LookupStatistics               m_lookupStatistics;
+        bool                           m_countLookups = false;
+        bool                           m_fastExit     = false;
+};
+
+#endif  // FS_TREE_H
@@ -13,7 +13,19 @@
 bool isFilename(std::string_view filename);
 
 /**
- * \brief Checks whether the provided character is a space.
+ * \brief Checks whether the string contains the wildcards '*' or '?'.
+ */
+bool isGlobPattern(std::string_view str);
+
+/**
+ * \brief Checks whether the name matches the wildcard pattern.
+ *
+ * '*' matches any sequence of characters (including the empty one), '?' matches any single character.
+ */
+bool matchesGlob(std::string_view pattern, std::string_view name);
+
+/**
+ * \brief Checks whether the provided character is a space (the same characters as std::isspace() in the "C" locale).
  * 
  * \return Non-zero value if the character is a whitespace character, zero otherwise.
  */
@@ -24,4 +36,9 @@ int isSpace(unsigned char c);
  */
 void trim(std::string& str);
 
+/**
+ * \brief Helper: returns the part of the string without leading and trailing whitespaces.
+ */
+std::string_view trimmed(std::string_view str);
+
 #endif  // HELPERS_H
@@ -1,7 +1,27 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <string>
 #include <string_view>
+#include <utility>
+
+#include "fme_metrics.h"
+
+/**
+ * \brief LogLevel defines the severity of the log messages in ascending order.
+ */
+enum class LogLevel
+{
+    Info,
+    Warning,
+    Error,
+    Off  /// Used only as the minimum level: disables all messages.
+};
 
 /**
  * \brief Base class for logging messages with different severity levels into the console.
@@ -9,14 +29,87 @@
  * Provides methods to log errors, warnings, and informational messages.
  * Output formatting is consistent ("ERROR:", "WARNING:", "INFO:").
  * Derived classes can override writeLog() to customize log sinks (file, network, etc.).
+ * Derived classes, which override writeLog(), should also override writeLogChunk() and finishLog()
+ * to receive the long messages written via ChunkedLog.
+ * Messages with the level below the minimum level are dropped before formatting.
+ * Messages aren't flushed one by one: the sink is flushed by flush(), so the caller chooses the flush points.
  */
 class Logger
 {
     public:
-        Logger() = default;
+        /**
+         * \brief ChunkedLog writes one long message into the sink in chunks of bounded size.
+         *
+         * The text passed to append() is collected in the buffer of the fixed capacity, the full buffer
+         * is passed to Logger::writeLogChunk(). The message is finished when the ChunkedLog is destroyed.
+         */
+        class ChunkedLog final
+        {
+            public:
+                ChunkedLog(const ChunkedLog&) = delete;
+                ChunkedLog(ChunkedLog&&)      = delete;
+
+                ~ChunkedLog();
+
+                ChunkedLog& operator=(const ChunkedLog&) = delete;
+                ChunkedLog& operator=(ChunkedLog&&)      = delete;
+
+                /// Appends the text to the message.
+                ChunkedLog& append(std::string_view text);
+                /// Returns false if writing of any chunk failed.
+                bool        good() const noexcept;
+
+            private:
+                friend class Logger;
+
+                ChunkedLog(Logger& logger, std::string_view logType, bool enabled);
+
+                void flushBuffer();
+
+            private:
+                Logger&                               m_logger;
+                std::string                           m_buffer;
+                std::uint64_t                         m_bytesLogged = 0;
+                std::chrono::steady_clock::time_point m_start;
+                bool                                  m_enabled = true;
+                bool                                  m_good    = true;
+        };
+
+        /**
+         * \brief Statistics of the logged messages. They are collected only if the metrics are enabled.
+         */
+        struct Statistics
+        {
+                std::uint64_t            bytesLogged = 0;
+                std::chrono::nanoseconds loggingTime = {};  /// The time of formatting and writing of the messages.
+        };
+
+    public:
+        /**
+         * \brief Constructs a Logger.
+         *
+         * \param minLevel Messages with lower level are not logged.
+         */
+        explicit Logger(LogLevel minLevel = LogLevel::Info);
 
         virtual ~Logger() = default;
 
+        /// Checks whether the messages of the level are logged.
+        bool              isEnabled(LogLevel level) const noexcept;
+        /// Returns the minimum level of the logged messages.
+        LogLevel          minLevel() const noexcept;
+        /// Enables the collection of the statistics (if the metrics are enabled at compile time).
+        void              setCollectStatistics(bool collectStatistics) noexcept;
+        /// Sets the minimum level of the logged messages.
+        void              setMinLevel(LogLevel minLevel) noexcept;
+        /// Returns the statistics of the logged messages.
+        const Statistics& statistics() const noexcept;
+
+        /**
+         * \brief Writes all buffered messages into the sink.
+         */
+        virtual void flush();
+
         /// Logs an error message (prepends "ERROR: " and optionally the command string).
         bool logError(std::string_view errorMessage, std::string_view commandString = "");
 
@@ -26,14 +119,81 @@ class Logger
         /// Logs a warning message (prepends "WARNING: " and optionally the command string).
         bool logWarning(std::string_view warningMessage, std::string_view commandString = "");
 
+        /// Starts a long informational message (prepends "INFO: "), which is written in chunks.
+        ChunkedLog startChunkedInfo();
+
+        /// Writes the line as is (without the prefix) regardless of the minimum level, for example, the results.
+        bool writeLine(std::string_view line);
+
+        /**
+         * \brief Logs a message of the level (prepends "ERROR: ", "INFO: " or "WARNING: ").
+         *
+         * The message is formatted only if the level is enabled, so the disabled messages cost only the check.
+         * The message is formatted into the internal buffer of the logger, which is reused for the next messages.
+         */
+        template<LogLevel level, typename... Args>
+        bool log(std::format_string<Args...> format, Args&&... args)
+        {
+            if (!isEnabled(level))
+            {
+                return true;
+            }
+
+            const auto start = m_collectStatistics ? metricsNow() : std::chrono::steady_clock::time_point{};
+            m_formatBuffer.assign(levelPrefix(level));
+            std::format_to(std::back_inserter(m_formatBuffer), format, std::forward<Args>(args)...);
+            const auto written = writeLog(m_formatBuffer);
+            countLog(m_formatBuffer.size(), start);
+            return written;
+        }
+
     protected:
+        /**
+         * \brief Finishes the message written with writeLogChunk().
+         *
+         * \return true if writing succeeded, false otherwise.
+         */
+        virtual bool finishLog();
         /**
          * \brief Writes a formatted log string to the underlying sink.
-         * 
+         *
          * \param log Formatted log message.
          * \return true if writing succeeded, false otherwise.
          */
         virtual bool writeLog(std::string_view log);
+        /**
+         * \brief Writes a part of the formatted log string to the underlying sink.
+         *
+         * The message is finished by finishLog().
+         *
+         * \param chunk The next part of the formatted log message.
+         * \return true if writing succeeded, false otherwise.
+         */
+        virtual bool writeLogChunk(std::string_view chunk);
+
+    private:
+        /// Adds the logged message to the statistics.
+        void                    countLog(std::size_t bytes, std::chrono::steady_clock::time_point start) noexcept
+        {
+            if constexpr (metricsEnabled)
+            {
+                if (m_collectStatistics)
+                {
+                    m_statistics.bytesLogged += bytes;
+                    m_statistics.loggingTime += metricsNow() - start;
+                }
+            }
+        }
+        /// Returns the prefix of the messages of the level ("ERROR: ", "INFO: " or "WARNING: ").
+        static std::string_view levelPrefix(LogLevel level) noexcept;
+        /// Formats and writes the message of the level with the optional command string.
+        bool                    writeMessage(LogLevel level, std::string_view commandString, std::string_view message);
+
+    private:
+        LogLevel    m_minLevel = LogLevel::Info;
+        std::string m_formatBuffer;
+        Statistics  m_statistics;
+        bool        m_collectStatistics = false;
 };
 
 #endif  // LOGGER_H
@@ -0,0 +1,50 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * \brief MappedFile maps a regular file into the memory for reading.
+ *
+ * The content of the file is accessed via data() without copying into the user buffers.
+ * Only regular files can be mapped. Mapping is supported on POSIX systems only,
+ * on other systems open() always fails, so the caller can fall back to the stream reading.
+ */
+class MappedFile final
+{
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile(MappedFile&&)      = delete;
+
+        ~MappedFile();
+
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile& operator=(MappedFile&&)      = delete;
+
+        /**
+         * \brief Returns the content of the mapped file (empty if the file isn't mapped).
+         */
+        std::string_view data() const noexcept;
+        /**
+         * \brief Checks whether the file is mapped.
+         */
+        bool             isOpen() const noexcept;
+        /**
+         * \brief Maps the file. The previously mapped file is unmapped.
+         *
+         * \return false if the file cannot be mapped, errno describes the reason.
+         */
+        bool             open(std::string_view path);
+
+    private:
+        void unmap() noexcept;
+
+    private:
+        void*       m_data   = nullptr;
+        std::size_t m_size   = 0;
+        bool        m_isOpen = false;
+};
+
+#endif  // MAPPED_FILE_H
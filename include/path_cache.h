@@ -0,0 +1,77 @@
+#ifndef PATH_CACHE_H
+#define PATH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct FsNode;
+
+/**
+ * \brief PathCache maps normalized absolute paths to the resolved nodes.
+ *
+ * The cache is direct-mapped: a path is stored in the slot selected by its hash, so the cache has
+ * the fixed size and a lookup is one hash computation and one string comparison.
+ * Every entry remembers the generation of the cache. invalidate() starts the new generation,
+ * so all existing entries become stale in O(1), stale entries are overwritten lazily.
+ */
+class PathCache final
+{
+    public:
+        /**
+         * \brief Statistics describes the efficiency of the cache.
+         */
+        struct Statistics
+        {
+            std::size_t capacity      = 0;
+            std::size_t hits          = 0;
+            std::size_t misses        = 0;
+            std::size_t insertions    = 0;
+            std::size_t invalidations = 0;
+        };
+
+    public:
+        /**
+         * \brief Constructs a PathCache.
+         *
+         * \param capacity The number of slots (rounded up to the power of two). 0 disables the cache.
+         */
+        explicit PathCache(std::size_t capacity);
+
+        /**
+         * \brief Returns the node of the path or nullptr if the path isn't cached.
+         */
+        FsNode*           find(std::string_view path);
+        /**
+         * \brief Stores the node of the path (replaces the entry in the slot of the path).
+         */
+        void              insert(std::string_view path, FsNode* node);
+        /**
+         * \brief Makes all entries stale. Must be called when any cached node can be removed, moved or shared.
+         */
+        void              invalidate() noexcept;
+        /**
+         * \brief Changes the capacity of the cache, all entries are dropped.
+         */
+        void              resize(std::size_t capacity);
+        const Statistics& statistics() const noexcept;
+
+    private:
+        struct Entry
+        {
+            std::string   path;
+            FsNode*       node       = nullptr;
+            std::uint64_t generation = 0;  // 0 is never the current generation, so it marks empty entries
+        };
+
+        Entry* slot(std::string_view path) noexcept;
+
+    private:
+        std::vector<Entry> m_entries;
+        std::uint64_t      m_generation = 1;
+        Statistics         m_statistics;
+};
+
+#endif  // PATH_CACHE_H
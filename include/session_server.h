@@ -0,0 +1,93 @@
+#ifndef SESSION_SERVER_H
+#define SESSION_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "logger.h"
+
+/**
+ * \brief SessionServer runs many emulator sessions in one long-running process.
+ *
+ * The server listens on the Unix domain socket. Every connection is one session: the client sends the batch
+ * commands and shuts down writing, the server runs them and sends back the log of the session (as the standalone
+ * emulator writes it) followed by the line "RESULT: <error code>". The sessions are executed on the fixed pool
+ * of the worker threads.
+ *
+ * The trees cannot be shared across the threads, since the copy-on-write contents are reference counted by one
+ * thread, so every worker keeps its own emulator and loads the base tree from the snapshot once. A session starts
+ * with the copy of the base root, which shares all contents with the base, so the session costs O(1) for the start
+ * and O(changes) after it: a directory is cloned (only its own level) on its first change in the session, and
+ * the changed part of the previous session is freed in slices during the next one. The base itself is never
+ * changed. The workers don't share any mutable state. The log at the Info level prints the whole tree after
+ * every session, so it costs O(tree): the output itself is that large.
+ *
+ * The sockets are supported on POSIX systems only, on other systems run() always fails.
+ */
+class SessionServer final
+{
+    public:
+        /**
+         * \brief Settings of the server and of its sessions.
+         */
+        struct Settings
+        {
+                std::string                socketPath;
+                std::size_t                workersNumber = 1;
+                LogLevel                   logLevel      = LogLevel::Info;
+                bool                       pipeline      = false;
+                std::optional<std::size_t> pathCacheSize;
+                std::string                baseSnapshotPath;  /// The initial tree of every session (optional).
+        };
+
+    public:
+        explicit SessionServer(Settings settings);
+        SessionServer(const SessionServer&) = delete;
+        SessionServer(SessionServer&&)      = delete;
+
+        ~SessionServer() = default;
+
+        SessionServer& operator=(const SessionServer&) = delete;
+        SessionServer& operator=(SessionServer&&)      = delete;
+
+        /**
+         * \brief Listens on the socket and serves the sessions until stop() is called.
+         *
+         * \return false if the socket cannot be opened, errno describes the reason.
+         */
+        bool run();
+        /**
+         * \brief Stops accepting of the sessions, run() returns after the accepted sessions are served.
+         *
+         * The method is async-signal-safe, so it can be called from the signal handler.
+         */
+        void stop() noexcept;
+
+    private:
+        class Worker;
+
+        /**
+         * \brief Reads the commands from the connection, runs the session and sends the output back.
+         */
+        void serveConnection(int connection, Worker& worker) const;
+        /**
+         * \brief The main function of the worker threads.
+         */
+        void serveConnections();
+
+    private:
+        Settings                m_settings;
+        std::mutex              m_mutex;
+        std::condition_variable m_connectionsAvailable;
+        std::deque<int>         m_connections;  // The accepted connections, which wait for a worker
+        bool                    m_closed = false;
+        std::atomic<int>        m_listener{-1};
+        std::atomic<bool>       m_stopped{false};
+};
+
+#endif  // SESSION_SERVER_H
@@ -0,0 +1,87 @@
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * \brief A fixed-size block allocator which carves objects out of large slabs.
+ *
+ * The SlabAllocator hands out blocks of one size (the size of the object it was created for).
+ * Memory is requested from the system in slabs, each slab holds many blocks, so a single
+ * system allocation satisfies many allocate() calls. Released blocks are kept in an
+ * intrusive free list and reused by the next allocations. Slabs are returned to the system
+ * only when the allocator is destroyed.
+ *
+ * The allocator doesn't construct or destroy objects, it only manages raw memory.
+ */
+class SlabAllocator final
+{
+    public:
+        /**
+         * \brief Statistics describes the current and the accumulated usage of the allocator.
+         */
+        struct Statistics
+        {
+            std::size_t blockSize          = 0;  /// Size of one block in bytes.
+            std::size_t slabsNumber        = 0;  /// Number of slabs requested from the system.
+            std::size_t bytesReserved      = 0;  /// Total size of all slabs in bytes.
+            std::size_t blocksInUse        = 0;  /// Number of currently allocated blocks.
+            std::size_t peakBlocksInUse    = 0;  /// Maximum number of simultaneously allocated blocks.
+            std::size_t totalAllocations   = 0;  /// Number of allocate() calls.
+            std::size_t totalDeallocations = 0;  /// Number of deallocate() calls.
+        };
+
+    public:
+        /**
+         * \brief Constructs a SlabAllocator.
+         *
+         * \param blockSize The size of one block (usually sizeof of the allocated type).
+         * \param blockAlignment The alignment of one block (usually alignof of the allocated type).
+         */
+        SlabAllocator(std::size_t blockSize, std::size_t blockAlignment);
+        SlabAllocator(const SlabAllocator&) = delete;
+        SlabAllocator(SlabAllocator&&)      = delete;
+
+        ~SlabAllocator() = default;
+
+        SlabAllocator& operator=(const SlabAllocator&) = delete;
+        SlabAllocator& operator=(SlabAllocator&&)      = delete;
+
+        /**
+         * \brief Returns a block of memory. Requests a new slab if the free list is empty.
+         */
+        void*             allocate();
+        /**
+         * \brief Returns the block into the free list. The block must be allocated by this allocator.
+         */
+        void              deallocate(void* block) noexcept;
+        /**
+         * \brief Returns the usage statistics of the allocator.
+         */
+        const Statistics& statistics() const noexcept;
+
+    private:
+        /**
+         * \brief FreeBlock is placed in the memory of released blocks to link them into the free list.
+         */
+        struct FreeBlock
+        {
+            FreeBlock* next = nullptr;
+        };
+
+        /**
+         * \brief Requests a new slab, which is twice larger than the previous one (up to the limit).
+         */
+        void allocateSlab();
+
+    private:
+        std::size_t                               m_blockSize     = 0;
+        std::size_t                               m_blocksPerSlab = 0;
+        FreeBlock*                                m_freeList      = nullptr;
+        std::vector<std::unique_ptr<std::byte[]>> m_slabs;
+        Statistics                                m_statistics;
+};
+
+#endif  // SLAB_ALLOCATOR_H
@@ -0,0 +1,155 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief A bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * The queue is a ring buffer with the capacity rounded up to the power of two. tryPush() and tryPop()
+ * never block. push() and pop() wait (without spinning) while the queue is full or empty.
+ *
+ * The producer finishes the stream with close(): the consumer gets the remaining elements and then
+ * pop() returns false. The consumer abandons the stream with cancel(): push() returns false afterwards,
+ * so the producer doesn't wait for the space, which will never become free.
+ */
+template<typename T>
+class SpscQueue final
+{
+    public:
+        explicit SpscQueue(const std::size_t capacity) : m_slots(std::bit_ceil(capacity < 2 ? 2 : capacity))
+        {
+            m_mask = m_slots.size() - 1;
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue(SpscQueue&&)      = delete;
+
+        ~SpscQueue() = default;
+
+        SpscQueue& operator=(const SpscQueue&) = delete;
+        SpscQueue& operator=(SpscQueue&&)      = delete;
+
+        /**
+         * \brief Consumer: abandons the stream, the producer stops waiting and the next pushes fail.
+         */
+        void cancel() noexcept
+        {
+            m_head.fetch_or(stateBit, std::memory_order_acq_rel);
+            m_head.notify_all();
+        }
+
+        /**
+         * \brief Producer: finishes the stream, the consumer gets the remaining elements.
+         */
+        void close() noexcept
+        {
+            m_tail.fetch_or(stateBit, std::memory_order_acq_rel);
+            m_tail.notify_all();
+        }
+
+        /**
+         * \brief Consumer: waits for the next element.
+         *
+         * \return false if the queue is closed and empty.
+         */
+        bool pop(T& value)
+        {
+            while (!tryPop(value))
+            {
+                const auto tail = m_tail.load(std::memory_order_acquire);
+                if (index(tail) != index(m_head.load(std::memory_order_relaxed)))
+                {
+                    continue;
+                }
+                if (tail & stateBit)
+                {
+                    return false;
+                }
+                m_tail.wait(tail, std::memory_order_acquire);
+            }
+            return true;
+        }
+
+        /**
+         * \brief Producer: waits for the free space and pushes the element.
+         *
+         * \return false if the consumer has cancelled the stream.
+         */
+        bool push(T value)
+        {
+            while (!tryPush(value))
+            {
+                const auto head = m_head.load(std::memory_order_acquire);
+                if (head & stateBit)
+                {
+                    return false;
+                }
+                if (index(m_tail.load(std::memory_order_relaxed)) - index(head) < m_slots.size())
+                {
+                    continue;
+                }
+                m_head.wait(head, std::memory_order_acquire);
+            }
+            return true;
+        }
+
+        /**
+         * \brief Consumer: pops the element if the queue isn't empty.
+         */
+        bool tryPop(T& value)
+        {
+            const auto head = m_head.load(std::memory_order_relaxed);
+            if (index(head) == index(m_tail.load(std::memory_order_acquire)))
+            {
+                return false;
+            }
+
+            value = std::move(m_slots[index(head) & m_mask]);
+            m_head.store(head + indexStep, std::memory_order_release);
+            m_head.notify_one();
+            return true;
+        }
+
+        /**
+         * \brief Producer: pushes the element if the queue isn't full. The value is moved only on success.
+         */
+        bool tryPush(T& value)
+        {
+            const auto tail = m_tail.load(std::memory_order_relaxed);
+            const auto head = m_head.load(std::memory_order_acquire);
+            if ((head & stateBit) || index(tail) - index(head) == m_slots.size())
+            {
+                return false;
+            }
+
+            m_slots[index(tail) & m_mask] = std::move(value);
+            m_tail.store(tail + indexStep, std::memory_order_release);
+            m_tail.notify_one();
+            return true;
+        }
+
+    private:
+        // The lowest bit of the head is the "cancelled" flag, the lowest bit of the tail is the "closed" flag.
+        // The indexes are stored in the rest bits, so a single atomic variable is enough for waiting.
+        static constexpr std::size_t stateBit  = 1;
+        static constexpr std::size_t indexStep = 2;
+
+        static constexpr std::size_t index(const std::size_t value) noexcept
+        {
+            return value >> 1;
+        }
+
+    private:
+        std::vector<T> m_slots;
+        std::size_t    m_mask = 0;
+
+        alignas(64) std::atomic<std::size_t> m_head{0};  // Written only by the consumer (except the flag)
+        alignas(64) std::atomic<std::size_t> m_tail{0};  // Written only by the producer (except the flag)
+};
+
+#endif  // SPSC_QUEUE_H
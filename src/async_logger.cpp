@@ -0,0 +1,110 @@
+#include "async_logger.h"
+
+#include <algorithm>
+#include <ostream>
+
+AsyncLogger::AsyncLogger(std::ostream& sink, const LogLevel minLevel, const std::size_t bufferSize,
+                         const std::size_t buffersNumber) :
+    Logger{minLevel},
+    m_sink{sink},
+    m_bufferSize{std::max(bufferSize, std::size_t{1})},
+    m_buffers(std::max(buffersNumber, std::size_t{2})),
+    m_filledBuffers{m_buffers.size()},
+    m_freeBuffers{m_buffers.size()}
+{
+    for (auto& buffer : m_buffers)
+    {
+        buffer.reserve(m_bufferSize);
+        auto bufferPtr = &buffer;
+        m_freeBuffers.tryPush(bufferPtr);
+    }
+
+    m_freeBuffers.tryPop(m_currentBuffer);
+    m_writer = std::thread{&AsyncLogger::writeBuffers, this};
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    if (!m_currentBuffer->empty())
+    {
+        m_filledBuffers.push(m_currentBuffer);
+    }
+
+    m_filledBuffers.close();
+    m_writer.join();
+}
+
+void AsyncLogger::flush()
+{
+    if (!m_currentBuffer->empty())
+    {
+        submitCurrentBuffer();
+    }
+
+    // Wait until the writer thread writes all submitted buffers
+    for (auto written = m_writtenBuffers.load(std::memory_order_acquire); written != m_submittedBuffers;
+         written      = m_writtenBuffers.load(std::memory_order_acquire))
+    {
+        m_writtenBuffers.wait(written, std::memory_order_acquire);
+    }
+
+    // The writer thread is idle now, so the sink can be flushed from this thread
+    m_sink.flush();
+}
+
+bool AsyncLogger::finishLog()
+{
+    return append("\n");
+}
+
+bool AsyncLogger::writeLog(const std::string_view log)
+{
+    return append(log) && append("\n");
+}
+
+bool AsyncLogger::writeLogChunk(const std::string_view chunk)
+{
+    return append(chunk);
+}
+
+bool AsyncLogger::append(std::string_view text)
+{
+    while (m_currentBuffer->size() + text.size() > m_bufferSize)
+    {
+        const auto part = text.substr(0, m_bufferSize - m_currentBuffer->size());
+        m_currentBuffer->append(part);
+        text.remove_prefix(part.size());
+        submitCurrentBuffer();
+    }
+
+    m_currentBuffer->append(text);
+    return !m_sinkFailed.load(std::memory_order_relaxed);
+}
+
+void AsyncLogger::submitCurrentBuffer()
+{
+    m_filledBuffers.push(m_currentBuffer);
+    ++m_submittedBuffers;
+    m_freeBuffers.pop(m_currentBuffer);
+}
+
+void AsyncLogger::writeBuffers()
+{
+    auto buffer = static_cast<std::string*>(nullptr);
+
+    while (m_filledBuffers.pop(buffer))
+    {
+        if (!m_sink.write(buffer->data(), static_cast<std::streamsize>(buffer->size())))
+        {
+            m_sinkFailed.store(true, std::memory_order_relaxed);
+        }
+
+        buffer->clear();
+        m_freeBuffers.push(buffer);
+
+        m_writtenBuffers.fetch_add(1, std::memory_order_release);
+        m_writtenBuffers.notify_one();
+    }
+
+    m_sink.flush();
+}
@@ -0,0 +1,345 @@
+#include "byte_scanner.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FME_SCANNER_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define FME_SCANNER_AVX2
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define FME_SCANNER_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+constexpr inline auto byteClassesNumber = std::size_t{4};
+constexpr inline auto maxScannersNumber = std::size_t{3};
+constexpr inline auto shortScanSize     = std::size_t{16};  // The spans shorter than a vector are scanned inline
+constexpr inline auto controlSpaceFirst = '\t';  // '\t', '\n', '\v', '\f' and '\r' are consecutive
+constexpr inline auto controlSpaceLast  = '\r';
+
+using ScanFunction = std::size_t (*)(const char* data, std::size_t size, std::size_t pos) noexcept;
+
+/**
+ * \brief ByteScanner holds the functions of one instruction set: scans[byteClass][matching].
+ */
+struct ByteScanner
+{
+        std::string_view                                           name;
+        std::array<std::array<ScanFunction, 2>, byteClassesNumber> scans;
+};
+
+constexpr std::uint8_t classBit(const ByteClass byteClass) noexcept
+{
+    return static_cast<std::uint8_t>(1U << static_cast<unsigned>(byteClass));
+}
+
+constexpr inline auto byteClasses = []
+{
+    auto classes = std::array<std::uint8_t, 256>{};
+    for (const auto c : std::string_view{" \t\n\v\f\r"})
+    {
+        classes[static_cast<unsigned char>(c)] |= classBit(ByteClass::Space);
+    }
+    classes['"'] |= classBit(ByteClass::Quote);
+    classes['\n'] |= classBit(ByteClass::Newline);
+    classes['/'] |= classBit(ByteClass::Slash);
+    return classes;
+}();
+
+/**
+ * \brief Returns the single byte of the class (the space class is a set, so it's classified separately).
+ */
+template<ByteClass byteClass>
+constexpr char singleByte() noexcept
+{
+    static_assert(byteClass != ByteClass::Space);
+    return byteClass == ByteClass::Quote ? '"' : (byteClass == ByteClass::Newline ? '\n' : '/');
+}
+
+std::size_t scanBytes(const char* data, const std::size_t size, std::size_t pos, const ByteClass byteClass,
+                      const bool matching) noexcept
+{
+    const auto mask = classBit(byteClass);
+    while (pos < size && ((byteClasses[static_cast<unsigned char>(data[pos])] & mask) != 0) != matching)
+    {
+        ++pos;
+    }
+    return pos;
+}
+
+struct ScalarKernel
+{
+        template<ByteClass byteClass, bool matching>
+        static std::size_t scan(const char* data, const std::size_t size, const std::size_t pos) noexcept
+        {
+            return scanBytes(data, size, pos, byteClass, matching);
+        }
+};
+
+#ifdef FME_SCANNER_SSE2
+struct Sse2Kernel
+{
+        template<ByteClass byteClass>
+        static __m128i classify(const __m128i bytes) noexcept
+        {
+            if constexpr (byteClass == ByteClass::Space)
+            {
+                // The unsigned clamping leaves only the bytes of the range ['\t', '\r'] unchanged
+                const auto clamped = _mm_min_epu8(_mm_max_epu8(bytes, _mm_set1_epi8(controlSpaceFirst)),
+                                                  _mm_set1_epi8(controlSpaceLast));
+                return _mm_or_si128(_mm_cmpeq_epi8(bytes, clamped), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')));
+            }
+            else
+            {
+                return _mm_cmpeq_epi8(bytes, _mm_set1_epi8(singleByte<byteClass>()));
+            }
+        }
+
+        template<ByteClass byteClass, bool matching>
+        static std::size_t scan(const char* data, const std::size_t size, std::size_t pos) noexcept
+        {
+            for (; size - pos >= sizeof(__m128i); pos += sizeof(__m128i))
+            {
+                const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+                auto       found = static_cast<unsigned>(_mm_movemask_epi8(classify<byteClass>(bytes)));
+                if constexpr (!matching)
+                {
+                    found ^= 0xFFFFU;
+                }
+                if (found != 0)
+                {
+                    return pos + static_cast<std::size_t>(std::countr_zero(found));
+                }
+            }
+            return ScalarKernel::scan<byteClass, matching>(data, size, pos);
+        }
+};
+#endif
+
+#ifdef FME_SCANNER_AVX2
+struct Avx2Kernel
+{
+        template<ByteClass byteClass>
+        __attribute__((target("avx2"))) static __m256i classify(const __m256i bytes) noexcept
+        {
+            if constexpr (byteClass == ByteClass::Space)
+            {
+                const auto clamped = _mm256_min_epu8(_mm256_max_epu8(bytes, _mm256_set1_epi8(controlSpaceFirst)),
+                                                     _mm256_set1_epi8(controlSpaceLast));
+                return _mm256_or_si256(_mm256_cmpeq_epi8(bytes, clamped),
+                                       _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')));
+            }
+            else
+            {
+                return _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(singleByte<byteClass>()));
+            }
+        }
+
+        template<ByteClass byteClass, bool matching>
+        __attribute__((target("avx2"))) static std::size_t scan(const char* data, const std::size_t size,
+                                                                std::size_t pos) noexcept
+        {
+            for (; size - pos >= sizeof(__m256i); pos += sizeof(__m256i))
+            {
+                const auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+                auto       found = static_cast<std::uint32_t>(_mm256_movemask_epi8(classify<byteClass>(bytes)));
+                if constexpr (!matching)
+                {
+                    found = ~found;
+                }
+                if (found != 0)
+                {
+                    return pos + static_cast<std::size_t>(std::countr_zero(found));
+                }
+            }
+            // The tail shorter than 32 bytes (the most of the command arguments) is scanned by 16 bytes
+            return Sse2Kernel::scan<byteClass, matching>(data, size, pos);
+        }
+};
+#endif
+
+#ifdef FME_SCANNER_NEON
+struct NeonKernel
+{
+        template<ByteClass byteClass>
+        static uint8x16_t classify(const uint8x16_t bytes) noexcept
+        {
+            if constexpr (byteClass == ByteClass::Space)
+            {
+                const auto controlSpaces = vcleq_u8(vsubq_u8(bytes, vdupq_n_u8(controlSpaceFirst)),
+                                                    vdupq_n_u8(controlSpaceLast - controlSpaceFirst));
+                return vorrq_u8(controlSpaces, vceqq_u8(bytes, vdupq_n_u8(' ')));
+            }
+            else
+            {
+                return vceqq_u8(bytes, vdupq_n_u8(singleByte<byteClass>()));
+            }
+        }
+
+        template<ByteClass byteClass, bool matching>
+        static std::size_t scan(const char* data, const std::size_t size, std::size_t pos) noexcept
+        {
+            for (; size - pos >= sizeof(uint8x16_t); pos += sizeof(uint8x16_t))
+            {
+                const auto bytes = vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + pos));
+                // NEON has no movemask: the narrowing shift packs every byte of the mask into 4 bits
+                const auto nibbles = vshrn_n_u16(vreinterpretq_u16_u8(classify<byteClass>(bytes)), 4);
+                auto       found   = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+                if constexpr (!matching)
+                {
+                    found = ~found;
+                }
+                if (found != 0)
+                {
+                    return pos + static_cast<std::size_t>(std::countr_zero(found)) / 4;
+                }
+            }
+            return ScalarKernel::scan<byteClass, matching>(data, size, pos);
+        }
+};
+#endif
+
+template<typename Kernel>
+constexpr std::array<ScanFunction, 2> makeScans(const ByteClass byteClass) noexcept
+{
+    switch (byteClass)
+    {
+        case ByteClass::Space:
+            return {Kernel::template scan<ByteClass::Space, false>, Kernel::template scan<ByteClass::Space, true>};
+        case ByteClass::Quote:
+            return {Kernel::template scan<ByteClass::Quote, false>, Kernel::template scan<ByteClass::Quote, true>};
+        case ByteClass::Newline:
+            return {Kernel::template scan<ByteClass::Newline, false>,
+                    Kernel::template scan<ByteClass::Newline, true>};
+        case ByteClass::Slash:
+            return {Kernel::template scan<ByteClass::Slash, false>, Kernel::template scan<ByteClass::Slash, true>};
+    }
+    return {};
+}
+
+template<typename Kernel>
+constexpr ByteScanner makeScanner(const std::string_view name) noexcept
+{
+    return {name,
+            {makeScans<Kernel>(ByteClass::Space), makeScans<Kernel>(ByteClass::Quote),
+             makeScans<Kernel>(ByteClass::Newline), makeScans<Kernel>(ByteClass::Slash)}};
+}
+
+constexpr inline auto scalarScanner = makeScanner<ScalarKernel>("scalar");
+#ifdef FME_SCANNER_SSE2
+constexpr inline auto sse2Scanner = makeScanner<Sse2Kernel>("sse2");
+#endif
+#ifdef FME_SCANNER_AVX2
+constexpr inline auto avx2Scanner = makeScanner<Avx2Kernel>("avx2");
+#endif
+#ifdef FME_SCANNER_NEON
+constexpr inline auto neonScanner = makeScanner<NeonKernel>("neon");
+#endif
+
+struct SupportedScanners
+{
+        std::array<const ByteScanner*, maxScannersNumber> scanners = {};
+        std::array<std::string_view, maxScannersNumber>   names    = {};
+        std::size_t                                       size     = 0;
+
+        void add(const ByteScanner& scanner) noexcept
+        {
+            scanners[size] = &scanner;
+            names[size++]  = scanner.name;
+        }
+};
+
+const SupportedScanners& supportedScanners() noexcept
+{
+    static const auto supported = []
+    {
+        auto scanners = SupportedScanners{};
+#ifdef FME_SCANNER_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            scanners.add(avx2Scanner);
+        }
+#endif
+#ifdef FME_SCANNER_SSE2
+        scanners.add(sse2Scanner);  // SSE2 is the baseline of x86-64
+#endif
+#ifdef FME_SCANNER_NEON
+        scanners.add(neonScanner);  // NEON is the baseline of AArch64
+#endif
+        scanners.add(scalarScanner);
+        return scanners;
+    }();
+    return supported;
+}
+
+const ByteScanner*& activeScanner() noexcept
+{
+    static auto* scanner = supportedScanners().scanners[0];
+    return scanner;
+}
+
+std::size_t scan(const std::string_view str, const ByteClass byteClass, const std::size_t pos,
+                 const bool matching) noexcept
+{
+    if (pos >= str.size())
+    {
+        return str.size();
+    }
+    if (str.size() - pos < shortScanSize)
+    {
+        // The most of the spans between the separators are short: the indirect call costs more than the scan
+        return scanBytes(str.data(), str.size(), pos, byteClass, matching);
+    }
+    const auto& scans = activeScanner()->scans[static_cast<std::size_t>(byteClass)];
+    return scans[matching ? 1 : 0](str.data(), str.size(), pos);
+}
+
+}  // namespace
+
+bool isByteOf(const unsigned char c, const ByteClass byteClass) noexcept
+{
+    return (byteClasses[c] & classBit(byteClass)) != 0;
+}
+
+std::size_t findByteOf(const std::string_view str, const ByteClass byteClass, const std::size_t pos) noexcept
+{
+    return scan(str, byteClass, pos, true);
+}
+
+std::size_t skipBytesOf(const std::string_view str, const ByteClass byteClass, const std::size_t pos) noexcept
+{
+    return scan(str, byteClass, pos, false);
+}
+
+std::span<const std::string_view> supportedByteScanners() noexcept
+{
+    const auto& supported = supportedScanners();
+    return {supported.names.data(), supported.size};
+}
+
+std::string_view byteScannerName() noexcept
+{
+    return activeScanner()->name;
+}
+
+bool selectByteScanner(const std::string_view name) noexcept
+{
+    const auto& supported = supportedScanners();
+    for (auto i = std::size_t{0}; i < supported.size; ++i)
+    {
+        if (supported.names[i] == name)
+        {
+            activeScanner() = supported.scanners[i];
+            return true;
+        }
+    }
+    return false;
+}
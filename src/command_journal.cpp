@@ -0,0 +1,197 @@
+#include "command_journal.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <system_error>
+
+#include "mapped_file.h"
+
+namespace
+{
+constexpr inline char checkpointMagic[8] = {'F', 'M', 'E', 'C', 'K', 'P', 'T', '\0'};
+constexpr inline auto checkpointVersion  = std::uint32_t{1};
+constexpr inline auto checkpointSuffix   = std::string_view{".checkpoint"};
+constexpr inline auto temporarySuffix    = std::string_view{".tmp"};
+
+// The size of the group of the commands written at once
+constexpr inline auto groupCommitSize = std::size_t{64 * 1024};
+
+struct CheckpointHeader
+{
+        char          magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+        std::uint64_t journalSize;
+        std::uint64_t commandsNumber;
+};
+
+}  // namespace
+
+CommandJournal::CommandJournal(const std::string_view path) :
+    m_path{path},
+    m_checkpointPath{std::string{path}.append(checkpointSuffix)}
+{
+}
+
+CommandJournal::~CommandJournal()
+{
+    static_cast<void>(commit());
+}
+
+bool CommandJournal::append(const std::string_view commandString)
+{
+    m_buffer.append(commandString).push_back('\n');
+    ++m_commandsNumber;
+    return m_buffer.size() < groupCommitSize || commit();
+}
+
+const std::string& CommandJournal::checkpointPath() const noexcept
+{
+    return m_checkpointPath;
+}
+
+std::uint64_t CommandJournal::commandsNumber() const noexcept
+{
+    return m_commandsNumber;
+}
+
+bool CommandJournal::commit()
+{
+    if (m_buffer.empty())
+    {
+        return true;
+    }
+    if (!m_file.is_open())
+    {
+        return false;
+    }
+
+    m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_file.flush();
+    m_committedSize += m_buffer.size();
+    m_buffer.clear();
+    return m_file.good();
+}
+
+bool CommandJournal::continueAt(const std::uint64_t journalSize, const std::uint64_t commandsNumber)
+{
+    auto error = std::error_code{};
+    if (std::filesystem::exists(m_path, error))
+    {
+        std::filesystem::resize_file(m_path, journalSize, error);
+    }
+    else if (journalSize != 0)
+    {
+        return false;
+    }
+    if (error)
+    {
+        return false;
+    }
+
+    m_file.open(m_path, std::ofstream::out | std::ofstream::app | std::ofstream::binary);
+    m_buffer.clear();
+    m_committedSize  = journalSize;
+    m_commandsNumber = commandsNumber;
+    return m_file.is_open();
+}
+
+const std::string& CommandJournal::path() const noexcept
+{
+    return m_path;
+}
+
+SnapshotError CommandJournal::readCheckpoint(FsNodeStorage& storage, FsNodePtr& root, Checkpoint& checkpoint) const
+{
+    auto mappedFile = MappedFile{};
+    auto content    = std::string{};
+    auto data       = std::string_view{};
+
+    if (mappedFile.open(m_checkpointPath))
+    {
+        data = mappedFile.data();
+    }
+    else
+    {
+        auto stream = std::ifstream(m_checkpointPath, std::ifstream::in | std::ifstream::binary);
+        if (!stream.is_open())
+        {
+            return SnapshotError::CannotOpenFile;
+        }
+        content.assign(std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{});
+        data = content;
+    }
+
+    if (data.size() < sizeof(CheckpointHeader))
+    {
+        return SnapshotError::InvalidFormat;
+    }
+
+    auto header = CheckpointHeader{};
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, checkpointMagic, sizeof(checkpointMagic)) != 0 || header.version != checkpointVersion)
+    {
+        return SnapshotError::InvalidFormat;
+    }
+
+    const auto error = loadSnapshot(data.substr(sizeof(header)), storage, root);
+    if (error == SnapshotError::NoError)
+    {
+        checkpoint = Checkpoint{.journalSize = header.journalSize, .commandsNumber = header.commandsNumber};
+    }
+    return error;
+}
+
+bool CommandJournal::start()
+{
+    auto error = std::error_code{};
+    std::filesystem::remove(m_checkpointPath, error);
+    if (error)
+    {
+        return false;
+    }
+
+    m_file.open(m_path, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    m_buffer.clear();
+    m_committedSize  = 0;
+    m_commandsNumber = 0;
+    return m_file.is_open();
+}
+
+SnapshotError CommandJournal::writeCheckpoint(const FsNode& root)
+{
+    // The checkpoint refers to the end of the journal, so all journaled commands must be in the file
+    if (!commit())
+    {
+        return SnapshotError::CannotWriteFile;
+    }
+
+    const auto temporaryPath = std::string{m_checkpointPath}.append(temporarySuffix);
+    {
+        auto stream = std::ofstream(temporaryPath, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+        if (!stream.is_open())
+        {
+            return SnapshotError::CannotOpenFile;
+        }
+
+        auto header = CheckpointHeader{};
+        std::memcpy(header.magic, checkpointMagic, sizeof(checkpointMagic));
+        header.version        = checkpointVersion;
+        header.reserved       = 0;
+        header.journalSize    = m_committedSize;
+        header.commandsNumber = m_commandsNumber;
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        const auto error = saveSnapshot(root, stream);
+        if (error != SnapshotError::NoError)
+        {
+            return error;
+        }
+    }
+
+    // The previous checkpoint is replaced only by the complete one
+    auto error = std::error_code{};
+    std::filesystem::rename(temporaryPath, m_checkpointPath, error);
+    return error ? SnapshotError::CannotWriteFile : SnapshotError::NoError;
+}
@@ -1,137 +1,256 @@
 #include "command_parser.h"
 
-#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <istream>
-#include <limits>
-#include <map>
 
+#include "byte_scanner.h"
+#include "command_registry.h"
 #include "helpers.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#    include <unistd.h>
+#    define FME_HAS_DESCRIPTORS 1
+#endif
+
 namespace
 {
-const std::map<std::string, CommandName> commandsMap = {
-  {"cp", CommandName::Cp},
-  {"md", CommandName::Md},
-  {"mf", CommandName::Mf},
-  {"mv", CommandName::Mv},
-  {"rm", CommandName::Rm}
-};
+// The size of the block read from the file descriptor (the buffer grows for the longer lines)
+constexpr inline auto descriptorBlockSize = std::size_t{64 * 1024};
+
+void addArgument(Command& command, const std::string_view argument, const bool isPattern)
+{
+    if (command.argumentsNumber < Command::maxArgumentsNumber)
+    {
+        command.arguments[command.argumentsNumber] = argument;
+        command.patterns[command.argumentsNumber]  = isPattern;
+    }
+    ++command.argumentsNumber;
+}
 
 }  // namespace
 
-CommandParser::CommandParser(std::istream& inputStream) : m_inStream{inputStream}
+CommandParser::CommandParser(std::istream& inputStream) : m_inStream{&inputStream}
+{
+}
+
+CommandParser::CommandParser(const std::string_view input) : m_input{input}
+{
+}
+
+CommandParser::CommandParser(const int fileDescriptor) :
+    m_lineBuffer(descriptorBlockSize, '\0'), m_input{m_lineBuffer.data(), 0}, m_fileDescriptor{fileDescriptor}
+{
+}
+
+bool CommandParser::canReadDescriptors() noexcept
+{
+#ifdef FME_HAS_DESCRIPTORS
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string_view CommandParser::commandNameToString(const CommandName command) const
+{
+    return command == CommandName::Unknown ? "unknown" : commandSpec(command).name;
+}
+
+std::string_view CommandParser::errorToString(const CommandErrorCode errorCode) const
 {
+    switch (errorCode)
+    {
+        case CommandErrorCode::UnknownCommand:
+            return "Unknown command is met: ";
+        case CommandErrorCode::EmptyArgument:
+            return "Empty argument \"\" is found.";
+        case CommandErrorCode::ClosingQuotesMissing:
+            return "Closing quotes \" symbol is not found.";
+        default:
+            return "";
+    }
 }
 
-std::string CommandParser::commandNameToString(const CommandName command) const
+Command CommandParser::getNextCommand()
 {
-    for (const auto& [str, cmd] : commandsMap)
+    if (m_inStream)
     {
-        if (cmd == command)
+        return getNextStreamCommand();
+    }
+
+    // The line of the descriptor is parsed as the memory input, when it is complete
+    while (!hasBufferedCommand())
+    {
+        if (!readDescriptor())
         {
-            return str;
+            break;
         }
     }
-    return "unknown";
+    return getNextMemoryCommand();
 }
 
-Command CommandParser::getNextCommand()
+bool CommandParser::hasBufferedCommand() const noexcept
+{
+    if (m_inStream)
+    {
+        return false;
+    }
+    if (m_fileDescriptor < 0)
+    {
+        return true;
+    }
+    const auto nameStart = skipBytesOf(m_input, ByteClass::Space, m_inputPos);
+    return nameStart < m_input.size() && findByteOf(m_input, ByteClass::Newline, nameStart) < m_input.size();
+}
+
+bool CommandParser::hasMoreInput()
 {
     if (!m_inStream)
     {
-        return Command{};
+        m_inputPos = skipBytesOf(m_input, ByteClass::Space, m_inputPos);
+        while (m_inputPos == m_input.size() && readDescriptor())
+        {
+            m_inputPos = skipBytesOf(m_input, ByteClass::Space, m_inputPos);
+        }
+        return m_inputPos < m_input.size();
+    }
+
+    *m_inStream >> std::ws;
+
+    if (!m_inStream->good())
+    {
+        return false;
     }
 
-    auto cmdPartStr = std::string{};
+    const auto c = m_inStream->peek();
+    return c != EOF;
+}
 
-    // Read command name
-    m_inStream >> std::ws >> cmdPartStr;
+Command CommandParser::makeCommand(const std::string_view commandString) const
+{
+    const auto commandNameSize = findByteOf(commandString, ByteClass::Space);
+    const auto commandNameStr = commandString.substr(0, commandNameSize);
 
-    auto       commandString = cmdPartStr;
-    const auto cmdName       = parseCommandName(cmdPartStr);
-    if (cmdName == CommandName::Unknown)
+    auto command          = Command{};
+    command.commandString = commandString;
+    command.name          = parseCommandName(commandNameStr);
+    if (command.name == CommandName::Unknown)
     {
-        const auto errorStr = std::string{"Unknown command is met: "} + cmdPartStr;
-        m_inStream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');  // Skip the rest of the command
+        command.commandString = commandNameStr;
+        command.error = CommandError{.code = CommandErrorCode::UnknownCommand, .offset = 0, .length = commandNameSize};
+        return command;
+    }
+
+    parseCommandArguments(command, commandNameSize);
+    return command;
+}
 
-        return Command{.commandString = "",
-                       .name          = CommandName::Unknown,
-                       .arguments     = {},
-                       .error         = std::move(errorStr)};
+Command CommandParser::getNextMemoryCommand()
+{
+    // The same rules as for the stream: the command name is the next word,
+    // the arguments are the rest of the line.
+    const auto nameStart = skipBytesOf(m_input, ByteClass::Space, m_inputPos);
+    if (nameStart == m_input.size())
+    {
+        m_inputPos = m_input.size();
+        return Command{};
     }
 
-    // Read command arguments
-    std::getline(m_inStream, cmdPartStr);
-    commandString              += cmdPartStr;
-    auto argumentsParsingError  = std::optional<std::string>{};
+    const auto lineEnd = findByteOf(m_input, ByteClass::Newline, nameStart);
+    m_inputPos         = lineEnd == m_input.size() ? m_input.size() : lineEnd + 1;
 
-    return Command{.commandString = commandString,
-                   .name          = cmdName,
-                   .arguments     = parseCommandArguments(cmdPartStr, argumentsParsingError),
-                   .error         = argumentsParsingError};
+    return makeCommand(m_input.substr(nameStart, lineEnd - nameStart));
 }
 
-bool CommandParser::hasMoreInput()
+Command CommandParser::getNextStreamCommand()
 {
-    m_inStream >> std::ws;
-
-    if (!m_inStream.good())
+    if (!*m_inStream)
     {
-        return false;
+        return Command{};
     }
 
-    const auto c = m_inStream.peek();
-    return c != EOF;
+    // The command name is the first word of the line, the arguments are the rest of the line.
+    // The buffer is reused, so reading doesn't allocate memory after the longest line is met.
+    std::getline(*m_inStream >> std::ws, m_lineBuffer);
+    return makeCommand(m_lineBuffer);
 }
 
-CommandName CommandParser::parseCommandName(const std::string_view commandStr) const
+bool CommandParser::readDescriptor()
 {
-    const auto cmd = std::string{commandStr};
+#ifdef FME_HAS_DESCRIPTORS
+    if (m_fileDescriptor < 0)
+    {
+        return false;
+    }
+
+    // The strings of the previous command are valid only until this call, so its line can be dropped
+    const auto pending = m_input.size() - m_inputPos;
+    std::memmove(m_lineBuffer.data(), m_lineBuffer.data() + m_inputPos, pending);
+    if (pending == m_lineBuffer.size())
+    {
+        m_lineBuffer.resize(m_lineBuffer.size() * 2);
+    }
 
-    if (const auto it = commandsMap.find(cmd); it != commandsMap.end())
+    auto received = ::read(m_fileDescriptor, m_lineBuffer.data() + pending, m_lineBuffer.size() - pending);
+    while (received < 0 && errno == EINTR)
     {
-        return it->second;
+        received = ::read(m_fileDescriptor, m_lineBuffer.data() + pending, m_lineBuffer.size() - pending);
     }
-    return CommandName::Unknown;
+    if (received <= 0)
+    {
+        m_fileDescriptor = -1;  // The rest of the buffer is parsed as the memory input
+    }
+
+    m_input    = std::string_view{m_lineBuffer.data(), pending + static_cast<std::size_t>(received > 0 ? received : 0)};
+    m_inputPos = 0;
+    return received > 0;
+#else
+    return false;
+#endif
 }
 
-std::vector<std::string> CommandParser::parseCommandArguments(const std::string_view      commandStr,
-                                                              std::optional<std::string>& outParsingError) const
+CommandName CommandParser::parseCommandName(const std::string_view commandStr) const
 {
+    return findCommand(commandStr);
+}
+
+void CommandParser::parseCommandArguments(Command& command, const std::size_t argumentsOffset) const
+{
+    const auto commandStr = command.commandString.substr(argumentsOffset);
     if (commandStr.empty())
     {
-        return {};
+        return;
     }
 
-    constexpr auto quotesChar = '"';
-    auto           startPos = std::size_t{0}, quotesPos = std::size_t{0};
-    auto           quotesCounter   = 0;
-    auto           parsedArguments = std::vector<std::string>{};
+    auto startPos = std::size_t{0}, quotesPos = std::size_t{0};
+    auto quotesCounter = 0;
 
     const auto findNextQuotes = [=, &startPos]()
     {
-        return commandStr.find_first_of(quotesChar, startPos);
+        return findByteOf(commandStr, ByteClass::Quote, startPos);
     };
 
-    for (quotesPos = findNextQuotes(); quotesPos != std::string::npos; quotesPos = findNextQuotes())
+    for (quotesPos = findNextQuotes(); quotesPos < commandStr.size(); quotesPos = findNextQuotes())
     {
         if (quotesCounter % 2 == 0)
         {
-            parseCommandArgumentsByWhitespaces(parsedArguments, commandStr.substr(startPos, quotesPos - startPos));
+            parseCommandArgumentsByWhitespaces(command, commandStr.substr(startPos, quotesPos - startPos));
         }
         else
         {
             // The part between open " and end " is one argument
-            auto arg = std::string{commandStr.substr(startPos, quotesPos - startPos)};
-            trim(arg);
+            const auto arg = trimmed(commandStr.substr(startPos, quotesPos - startPos));
 
             if (arg.empty())
             {
-                outParsingError = "Empty argument \"\" is found.";
-                return parsedArguments;
+                command.error = CommandError{.code   = CommandErrorCode::EmptyArgument,
+                                             .offset = argumentsOffset + startPos - 1,
+                                             .length = quotesPos - startPos + 2};
+                return;
             }
 
-            parsedArguments.push_back(std::move(arg));
+            addArgument(command, arg, false);
         }
 
         startPos = quotesPos + 1;
@@ -140,17 +259,17 @@ std::vector<std::string> CommandParser::parseCommandArguments(const std::string_
 
     if (quotesCounter % 2 != 0)
     {
-        outParsingError = "Closing quotes \" symbol is not found.";
-        return parsedArguments;
+        command.error = CommandError{.code   = CommandErrorCode::ClosingQuotesMissing,
+                                     .offset = argumentsOffset + startPos - 1,
+                                     .length = commandStr.length() - startPos + 1};
+        return;
     }
 
     // Parse the rest of the string
-    parseCommandArgumentsByWhitespaces(parsedArguments, commandStr.substr(startPos, commandStr.length() - startPos));
-    return parsedArguments;
+    parseCommandArgumentsByWhitespaces(command, commandStr.substr(startPos, commandStr.length() - startPos));
 }
 
-void CommandParser::parseCommandArgumentsByWhitespaces(std::vector<std::string>& parsedArguments,
-                                                       const std::string_view    commandStr) const
+void CommandParser::parseCommandArgumentsByWhitespaces(Command& command, const std::string_view commandStr) const
 {
     if (commandStr.empty())
     {
@@ -161,16 +280,17 @@ void CommandParser::parseCommandArgumentsByWhitespaces(std::vector<std::string>&
 
     const auto findNextWord = [=, &startPos]()
     {
-        return std::find_if_not(commandStr.begin() + startPos, commandStr.end(), isSpace) - commandStr.begin();
+        return skipBytesOf(commandStr, ByteClass::Space, startPos);
     };
 
     for (startPos = findNextWord(); startPos < commandStr.size(); startPos = findNextWord())
     {
-        endPos = std::find_if(commandStr.begin() + startPos, commandStr.end(), isSpace) - commandStr.begin();
+        endPos = findByteOf(commandStr, ByteClass::Space, startPos);
 
         if (endPos - startPos > 0)
         {
-            parsedArguments.emplace_back(commandStr.substr(startPos, endPos - startPos));
+            const auto arg = commandStr.substr(startPos, endPos - startPos);
+            addArgument(command, arg, isGlobPattern(arg));
         }
 
         startPos = endPos;
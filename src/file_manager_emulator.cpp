@@ -2,50 +2,208 @@
 
 #include <algorithm>
 #include <cstring>
+#include <exception>
+#include <filesystem>
 #include <format>
 #include <fstream>
-#include <functional>
 #include <iostream>
-#include <map>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
 
+#include "byte_scanner.h"
+#include "command_journal.h"
 #include "command_parser.h"
+#include "command_registry.h"
+#include "fs_snapshot.h"
 #include "helpers.h"
 #include "logger.h"
+#include "mapped_file.h"
+#include "spsc_queue.h"
 
 namespace
 {
-constexpr inline auto pathDelimiter = '/';
+// The number of the commands parsed ahead in the pipelined mode
+constexpr inline auto pipelineCapacity = std::size_t{1024};
 
-std::string formatPathErrorMsg(const std::string_view normalizedNodePath, const std::string_view errorMsg)
+// The maximum number of the removed nodes freed after every command
+constexpr inline auto reclaimSliceSize = std::size_t{4096};
+
+constexpr inline auto standardInputDescriptor = 0;
+
+// Wrong basename of the file. Files cannot be referenced with / in the end.
+constexpr inline auto invalidFileReferenceErrorMsg = "Invalid path {}: the basename {} is not a valid file name.";
+
+std::string_view transferModeToString(const CommandName name)
 {
-    return std::format("Invalid path {}: {}", normalizedNodePath, errorMsg);
-};
+    return name == CommandName::Cp ? "copy" : "move";
+}
+
+std::string_view nodeTypeToString(const bool isDirectory)
+{
+    return isDirectory ? "directory" : "file";
+}
 
-std::string formatInvalidFileReferenceErrorMsg(const std::string_view path, const std::string_view basename)
+bool isTransfer(const CommandName name)
 {
-    // Wrong basename of the file. Files cannot be referenced with / in the end.
-    return formatPathErrorMsg(path, std::format("the basename {} is not a valid file name.", basename));
-};
+    return name == CommandName::Cp || name == CommandName::Mv;
+}
 
-std::string nodeTransferModeToString(const FileManagerEmulator::NodeTransferMode nodeTransferMode)
+// The commands, which refer to any existing item
+bool isInspection(const CommandName name)
 {
-    return nodeTransferMode == FileManagerEmulator::NodeTransferMode::Copy ? "copy" : "move";
+    return name == CommandName::Du || name == CommandName::Rm;
 }
 
-std::string nodeTypeToString(const FileManagerEmulator::NodeType nodeType)
+void logFailure(Logger& logger, const CommandName name, const FsResult& result)
 {
-    if (nodeType == FileManagerEmulator::NodeType::Invalid)
+    const auto nodeTypeStr = nodeTypeToString(result.isDirectory);
+
+    switch (result.error)
     {
-        return "invalid";
+        case FsError::InvalidFileReference:
+            logger.log<LogLevel::Error>(invalidFileReferenceErrorMsg, result.path, result.component);
+            break;
+        case FsError::EmptyBasename:
+            logger.log<LogLevel::Error>("Invalid path {}: basename cannot be empty.", result.path);
+            break;
+        case FsError::NotADirectory:
+            logger.log<LogLevel::Error>("Invalid path {}: {} is not a directory.", result.path, result.component);
+            break;
+        case FsError::PathNotFound:
+            logger.log<LogLevel::Error>("Invalid path {}: {} does not contain the item {}.", result.path,
+                                        result.directory, result.component);
+            break;
+        case FsError::NoSuchItem:
+            logger.log<LogLevel::Error>("No such {} {}.", isInspection(name) ? "item" : nodeTypeStr, result.path);
+            break;
+        case FsError::NoMatches:
+            logger.log<LogLevel::Error>("No items match the pattern {}.", result.path);
+            break;
+        case FsError::AlreadyExists:
+            if (isTransfer(name))
+            {
+                logger.log<LogLevel::Error>("Cannot {} {} {} in {} because the item with such a name already exists "
+                                            "in {}.",
+                                            transferModeToString(name), nodeTypeStr, result.path, result.directory,
+                                            result.directory);
+            }
+            else
+            {
+                logger.log<LogLevel::Error>("Cannot create {} {}: parent directory {} already contains item {}.",
+                                            nodeTypeStr, result.path, result.directory, result.component);
+            }
+            break;
+        case FsError::RootTransfer:
+            logger.log<LogLevel::Error>("Cannot {} the root directory.", transferModeToString(name));
+            break;
+        case FsError::TransferIntoSubdirectory:
+            logger.log<LogLevel::Error>("Cannot {} the element {} into own subdirectory {}.", transferModeToString(name),
+                                        result.path, result.directory);
+            break;
+        case FsError::DestinationNotADirectory:
+            logger.log<LogLevel::Error>("Cannot {} the item {} in destination {} because destination is not a "
+                                        "directory.",
+                                        transferModeToString(name), result.path, result.directory);
+            break;
+        case FsError::DestinationIsFile:
+            logger.log<LogLevel::Error>("Cannot {} source {} {} in destination {} because destination is not a "
+                                        "directory.",
+                                        transferModeToString(name), nodeTypeStr, result.path, result.directory);
+            break;
+        default:
+            break;
+    }
+}
+
+void logBulkSuccess(Logger& logger, const CommandName name, const FsResult& result)
+{
+    if (name == CommandName::Rm)
+    {
+        logger.log<LogLevel::Info>("The {} items matching {} are removed.", result.matchesNumber, result.path);
+        return;
+    }
+
+    const auto transferredNumber = result.matchesNumber - result.ignoredNumber;
+    if (transferredNumber != 0)
+    {
+        logger.log<LogLevel::Info>("The {} items matching {} are {} in {}.", transferredNumber, result.path,
+                                   name == CommandName::Cp ? "copied" : "moved", result.directory);
+    }
+    if (result.ignoredNumber != 0)
+    {
+        logger.log<LogLevel::Info>("Ignore {} of {} items matching {} in {} because the items with such names "
+                                   "already exist in the {}.",
+                                   transferModeToString(name), result.ignoredNumber, result.path, result.directory,
+                                   result.directory);
+    }
+}
+
+void logSuccess(Logger& logger, const CommandName name, const FsResult& result)
+{
+    const auto nodeTypeStr = nodeTypeToString(result.isDirectory);
+
+    if (result.outcome == FsOutcome::Unchanged)
+    {
+        // Moving of the item into itself is ignored silently
+        return;
+    }
+    if (result.outcome == FsOutcome::Ignored)
+    {
+        if (isTransfer(name))
+        {
+            logger.log<LogLevel::Info>("Ignore {} of {} {} in {} because the item with such a name already exists "
+                                       "in the {}.",
+                                       transferModeToString(name), nodeTypeStr, result.path, result.directory,
+                                       result.directory);
+        }
+        else
+        {
+            logger.log<LogLevel::Info>("Ignore creation of the {} {} because the item with such a name already "
+                                       "exists.",
+                                       nodeTypeStr, result.path);
+        }
+        return;
+    }
+    if (result.matchesNumber != 0)
+    {
+        logBulkSuccess(logger, name, result);
+        return;
+    }
+
+    switch (name)
+    {
+        case CommandName::Cp:
+            logger.log<LogLevel::Info>("The {} {} is copied in {} with name {}.", nodeTypeStr, result.path,
+                                       result.directory, result.component);
+            break;
+        case CommandName::Du:
+            logger.log<LogLevel::Info>("The {} {} contains {} files and {} directories, the depth of its subtree "
+                                       "is {}.",
+                                       nodeTypeStr, result.path, result.stats.files, result.stats.directories,
+                                       result.stats.maxDepth);
+            break;
+        case CommandName::Md:
+        case CommandName::Mf:
+            logger.log<LogLevel::Info>("The {} {} is created.", nodeTypeStr, result.path);
+            break;
+        case CommandName::Mv:
+            logger.log<LogLevel::Info>("The {} {} is moved in {} with name {}.", nodeTypeStr, result.path,
+                                       result.directory, result.component);
+            break;
+        case CommandName::Rm:
+            logger.log<LogLevel::Info>("The item {} is removed.", result.path);
+            break;
+        default:
+            break;
     }
-    return nodeType == FileManagerEmulator::NodeType::Directory ? "directory" : "file";
 }
 
 }  // namespace
 
 FileManagerEmulator::FileManagerEmulator(std::unique_ptr<Logger> logger) :
-    m_logger{logger ? std::move(logger) : std::make_unique<Logger>()},
-    m_fsRoot{new FsNode{.name = std::string{pathDelimiter}, .isDirectory = true, .children = {}}}
+    m_logger{logger ? std::move(logger) : std::make_unique<Logger>()}
 {
 }
 
@@ -57,103 +215,377 @@ FileManagerEmulator::~FileManagerEmulator()
     }
 }
 
+const SlabAllocator::Statistics& FileManagerEmulator::directoryAllocatorStatistics() const
+{
+    return m_tree.directoryAllocatorStatistics();
+}
+
+const SlabAllocator::Statistics& FileManagerEmulator::nodeAllocatorStatistics() const
+{
+    return m_tree.nodeAllocatorStatistics();
+}
+
+bool FileManagerEmulator::loadSnapshot(const std::string_view snapshotPath)
+{
+    auto mappedFile = MappedFile{};
+    auto content    = std::string{};
+    auto data       = std::string_view{};
+
+    if (mappedFile.open(snapshotPath))
+    {
+        data = mappedFile.data();
+    }
+    else
+    {
+        // Other files (for example, named pipes) are read via the stream
+        auto stream = std::ifstream(std::string{snapshotPath}, std::ifstream::in | std::ifstream::binary);
+        if (!stream.is_open())
+        {
+            m_logger->log<LogLevel::Error>("{}: {}. {}", snapshotPath,
+                                           snapshotErrorToString(SnapshotError::CannotOpenFile), std::strerror(errno));
+            return false;
+        }
+        content.assign(std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{});
+        data = content;
+    }
+
+    // The old tree is freed in slices between the commands
+    const auto error = m_tree.loadSnapshot(data);
+    if (error != SnapshotError::NoError)
+    {
+        m_logger->log<LogLevel::Error>("{}: {}.", snapshotPath, snapshotErrorToString(error));
+        return false;
+    }
+
+    m_logger->log<LogLevel::Info>("The snapshot {} is loaded.", snapshotPath);
+    return true;
+}
+
+FsTree::MemoryUsage FileManagerEmulator::memoryUsage() const
+{
+    return m_tree.memoryUsage();
+}
+
+Metrics FileManagerEmulator::metrics() const
+{
+    const auto& nodes   = m_tree.nodeAllocatorStatistics();
+    const auto& lookups = m_tree.lookupStatistics();
+    auto        result  = m_metrics;
+    result.nodesAllocated         = nodes.totalAllocations;
+    result.nodesFreed             = nodes.totalDeallocations;
+    result.peakNodes              = nodes.peakBlocksInUse;
+    result.pathComponentsResolved = lookups.pathComponentsResolved;
+    result.childrenLookups        = lookups.childrenLookups;
+    result.bytesLogged            = m_logger->statistics().bytesLogged;
+    return result;
+}
+
+bool FileManagerEmulator::openJournal(const std::string_view journalPath, const std::size_t checkpointInterval,
+                                      const bool resume)
+{
+    m_journal                 = std::make_unique<CommandJournal>(journalPath);
+    m_checkpointInterval      = checkpointInterval;
+    m_commandsSinceCheckpoint = 0;
+    m_skippedCommandsNumber   = 0;
+
+    if (resume)
+    {
+        return resumeJournal();
+    }
+    if (!m_journal->start())
+    {
+        m_logger->log<LogLevel::Error>("{}: Cannot open the journal file. {}", journalPath, std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+const PathCache::Statistics& FileManagerEmulator::pathCacheStatistics() const
+{
+    return m_tree.pathCacheStatistics();
+}
+
 void FileManagerEmulator::printFileTree() const
 {
-    auto output = std::string{"The FME file tree:\n"};
+    // The tree is traversed without recursion: every frame of the stack is a position in the children of
+    // one directory. The children are already ordered by names, so no sorting is needed.
+    // The output is streamed into the logger in chunks, so the whole tree is never kept in memory as a string.
+    struct Frame
+    {
+        FsChildren::const_iterator nextChild;
+        FsChildren::const_iterator end;
+    };
+
+    const auto makeFrame = [](const FsNode* node)
+    {
+        return Frame{.nextChild = node->children().begin(), .end = node->children().end()};
+    };
+    const auto nodeTypeShortStr = [](const FsNode* node)
+    {
+        return node->isDirectory() ? "  [D]\n" : "  [F]\n";
+    };
+
+    if (!m_logger->isEnabled(LogLevel::Info))
+    {
+        return;  // The disabled output mustn't walk the whole tree (for example, the large base of the sessions)
+    }
+
+    auto output = m_logger->startChunkedInfo();
+    const auto& root = m_tree.root();
+    output.append("The FME file tree:\n").append(root.name).append(nodeTypeShortStr(&root));
+
+    auto stack  = std::vector<Frame>{};
+    auto prefix = std::string{"|"};
+    stack.push_back(makeFrame(&root));
 
-    const std::function<void(const FsNode*, const std::string&)> printNode =
-      [&](const FsNode* node, const std::string& prefix)
+    while (!stack.empty())
     {
-        auto       nextPrefix       = prefix;
-        const auto nodeTypeShortStr = node->isDirectory ? "  [D]" : "  [F]";
+        auto& frame = stack.back();
 
-        if (prefix.empty())
+        if (frame.nextChild == frame.end)
         {
-            output     += node->name + nodeTypeShortStr + "\n";
-            nextPrefix  = "|";
+            stack.pop_back();
+            if (!stack.empty())
+            {
+                prefix.resize(prefix.size() - 2);
+            }
+            continue;
         }
-        else
+
+        const auto node = (frame.nextChild++)->get();
+        output.append(prefix).append("_").append(node->name).append(nodeTypeShortStr(node));
+
+        if (node->isDirectory() && !node->children().empty())
+        {
+            stack.push_back(makeFrame(node));
+            prefix.append(" |");
+        }
+    }
+}
+
+void FileManagerEmulator::printFileTreeChanges() const
+{
+    // The children of the baseline and of the tree are merged by names like in printFileTree(). The directories,
+    // which share the content with the baseline, are unchanged, so their subtrees are skipped. The changed
+    // directories are printed only when the first change inside them is found.
+    struct Frame
+    {
+        FsChildren::const_iterator nextOld;
+        FsChildren::const_iterator endOld;
+        FsChildren::const_iterator nextNew;
+        FsChildren::const_iterator endNew;
+        const FsNode*              node;
+    };
+
+    const auto  baseline = m_tree.baseline();
+    const auto& root     = m_tree.root();
+    if (!baseline || baseline->directory.get() == root.directory.get())
+    {
+        m_logger->log<LogLevel::Info>("The FME file tree is unchanged.");
+        return;
+    }
+
+    const auto makeFrame = [](const FsNode* oldNode, const FsNode* newNode)
+    {
+        return Frame{.nextOld = oldNode->children().begin(),
+                     .endOld  = oldNode->children().end(),
+                     .nextNew = newNode->children().begin(),
+                     .endNew  = newNode->children().end(),
+                     .node    = newNode};
+    };
+    const auto nodeTypeShortStr = [](const FsNode* node)
+    {
+        return node->isDirectory() ? "  [D]" : "  [F]";
+    };
+
+    auto output = m_logger->startChunkedInfo();
+    output.append("The FME file tree changes:\n  ").append(root.name).append(nodeTypeShortStr(&root)).append("\n");
+
+    auto stack        = std::vector<Frame>{};
+    auto prefix       = std::string{"|"};
+    auto printedDepth = std::size_t{1};  // The number of the frames, whose directories are printed
+    auto subtreeSize  = std::string{};
+    stack.push_back(makeFrame(baseline, &root));
+
+    const auto printLine = [&](const char* marker, const FsNode* node, const std::size_t depth)
+    {
+        output.append(marker).append(prefix.substr(0, depth * 2 - 1)).append("_").append(node->name);
+        output.append(nodeTypeShortStr(node));
+        if (*marker != ' ' && node->isDirectory() && node->stats().maxDepth != 0)
         {
-            output     += prefix + "_" + node->name + nodeTypeShortStr + "\n";
-            nextPrefix += " |";
+            // The added and the removed subtrees are summarized instead of printing
+            subtreeSize.clear();
+            std::format_to(std::back_inserter(subtreeSize), " with {} files and {} directories", node->stats().files,
+                           node->stats().directories);
+            output.append(subtreeSize);
         }
+        output.append("\n");
+    };
+    const auto printChange = [&](const char* marker, const FsNode* node)
+    {
+        for (; printedDepth < stack.size(); ++printedDepth)
+        {
+            printLine("  ", stack[printedDepth].node, printedDepth);
+        }
+        printLine(marker, node, stack.size());
+    };
 
-        auto sortedChildrenKeys = std::vector<std::string>{};
-        sortedChildrenKeys.reserve(node->children.size());
-        for (const auto& [childName, childPtr] : node->children)
+    while (!stack.empty())
+    {
+        auto& frame = stack.back();
+        if (frame.nextOld == frame.endOld && frame.nextNew == frame.endNew)
         {
-            if (childPtr)
+            stack.pop_back();
+            printedDepth = std::min(printedDepth, stack.size());
+            if (!stack.empty())
             {
-                sortedChildrenKeys.push_back(childName);
+                prefix.resize(prefix.size() - 2);
             }
+            continue;
         }
 
-        std::sort(sortedChildrenKeys.begin(), sortedChildrenKeys.end(),
-                  [](const auto& a, const auto& b)
-                  {
-                      return a < b;
-                  });
-
-        if (node->isDirectory)
+        const auto oldNode = frame.nextOld != frame.endOld ? frame.nextOld->get() : nullptr;
+        const auto newNode = frame.nextNew != frame.endNew ? frame.nextNew->get() : nullptr;
+        if (!newNode || (oldNode && oldNode->name < newNode->name))
         {
-            for (const auto& childName : sortedChildrenKeys)
-            {
-                printNode(node->children.at(childName).get(), nextPrefix);
-            }
+            ++frame.nextOld;
+            printChange("- ", oldNode);
+            continue;
+        }
+        if (!oldNode || newNode->name < oldNode->name)
+        {
+            ++frame.nextNew;
+            printChange("+ ", newNode);
+            continue;
         }
-    };
 
-    printNode(m_fsRoot.get(), "");
-    m_logger->logInfo(output);
+        ++frame.nextOld;
+        ++frame.nextNew;
+        if (oldNode->isDirectory() != newNode->isDirectory())
+        {
+            printChange("- ", oldNode);
+            printChange("+ ", newNode);
+        }
+        else if (newNode->isDirectory() && oldNode->directory.get() != newNode->directory.get())
+        {
+            // The frame can be moved by the push, so it isn't used after it
+            stack.push_back(makeFrame(oldNode, newNode));
+            prefix.append(" |");
+        }
+    }
 }
 
 ErrorCode FileManagerEmulator::run(const std::string_view batchFilePath)
+{
+    return runParser([this, batchFilePath]() { return initCommandParser(batchFilePath); });
+}
+
+ErrorCode FileManagerEmulator::runCommands(const std::string_view commands)
+{
+    return runParser(
+      [this, commands]()
+      {
+          m_parser      = std::make_unique<CommandParser>(commands);
+          m_readsMemory = true;
+          return true;
+      });
+}
+
+ErrorCode FileManagerEmulator::runParser(const std::function<bool()>& initParser)
 {
     const auto printResultTree = [this](ErrorCode code)
     {
+        code = finishTransactions(code);
+        if (m_journal && !m_journal->commit())
+        {
+            m_logger->log<LogLevel::Error>("{}: Cannot write the journal file.", m_journal->path());
+            code = code == ErrorCode::NoError ? ErrorCode::JournalError : code;
+        }
+
         if (code == ErrorCode::NoError)
         {
-            m_logger->logInfo("FileManagerEmulator::run() is over without error.");
+            m_logger->log<LogLevel::Info>("FileManagerEmulator::run() is over without error.");
+        }
+        else
+        {
+            m_logger->log<LogLevel::Warning>("FileManagerEmulator::run() is over with error.");
+        }
+        if (m_treeOutput == TreeOutput::Changes)
+        {
+            printFileTreeChanges();
+            m_tree.dropBaseline();
         }
         else
         {
-            m_logger->logWarning("FileManagerEmulator::run() is over with error.");
+            printFileTree();
         }
-        printFileTree();
+        m_logger->flush();
         return code;
     };
 
     try
     {
-        if (!initCommandParser(batchFilePath))
+        if (!initParser())
         {
             return ErrorCode::CannotOpenDataStream;
         }
-
-        while (m_parser->hasMoreInput())
+        if (m_treeOutput == TreeOutput::Changes)
         {
-            const auto command = m_parser->getNextCommand();
+            m_tree.keepBaseline();
+        }
 
-            if (m_fileInStream.is_open() && command.name != CommandName::Unknown)
+        if (m_skippedCommandsNumber != 0)
+        {
+            // The commands restored from the journal are already applied to the tree
+            auto skipped = std::uint64_t{0};
+            for (; skipped < m_skippedCommandsNumber && m_parser->hasMoreInput(); ++skipped)
             {
-                m_logger->logInfo(std::format("Executing command [{}] ...", command.commandString));
+                static_cast<void>(m_parser->getNextCommand());
             }
+            m_logger->log<LogLevel::Info>("{} commands restored from the journal are skipped.", skipped);
+            m_skippedCommandsNumber = 0;
+        }
+        if (m_transactional)
+        {
+            m_tree.beginTransaction();
+            m_batchTransaction = true;
+        }
+
+        // The commands of the batch files are logged before execution
+        const auto readsBatchFile = m_readsMemory || m_fileInStream.is_open();
 
-            if (command.name == CommandName::Unknown)
+        if (m_pipelined && readsBatchFile)
+        {
+            return printResultTree(runPipelined(readsBatchFile));
+        }
+
+        // Reading of standard input waits for the user, so only the parsing of the batch files is measured
+        const auto measureParsing = m_collectMetrics && readsBatchFile;
+        // The log is flushed only before waiting for the next command of standard input,
+        // so the commands written ahead by another process are answered by one write
+        const auto flushBeforeWaiting = [this, readsBatchFile]()
+        {
+            if (!readsBatchFile && !m_parser->hasBufferedCommand())
             {
-                m_logger->logError(command.error.has_value() ? command.error.value() : "Uknown command is met.");
-                return printResultTree(ErrorCode::CommandParsingError);
+                m_logger->flush();
             }
-            else if (command.error.has_value())
+        };
+        flushBeforeWaiting();
+        while (m_parser->hasMoreInput())
+        {
+            const auto parseStart = measureParsing ? metricsNow() : std::chrono::steady_clock::time_point{};
+            const auto command    = m_parser->getNextCommand();
+            if (measureParsing)
             {
-                m_logger->logError(command.error.value(), command.commandString);
-                return printResultTree(ErrorCode::CommandParsingError);
+                recordLatency(command.name, CommandPhase::Parse, parseStart);
             }
 
-            const auto executionResultCode = executeCommand(command);
-            if (executionResultCode != ErrorCode::NoError)
+            const auto resultCode = processCommand(command, readsBatchFile);
+            writeResultLine(command, resultCode);
+            flushBeforeWaiting();
+            if (resultCode != ErrorCode::NoError)
             {
-                return printResultTree(executionResultCode);
+                return printResultTree(resultCode);
             }
         }
 
@@ -161,549 +593,526 @@ ErrorCode FileManagerEmulator::run(const std::string_view batchFilePath)
     }
     catch (const std::exception& ex)
     {
-        m_logger->logError(std::format("Unexpected failure - {}", ex.what()));
+        m_logger->log<LogLevel::Error>("Unexpected failure - {}", ex.what());
         return printResultTree(ErrorCode::UknownException);
     }
     catch (...)
     {
-        m_logger->logError("Unknown exception occurred.");
+        m_logger->log<LogLevel::Error>("Unknown exception occurred.");
         return printResultTree(ErrorCode::UknownException);
     }
 }
 
-bool FileManagerEmulator::cp(const std::string_view source, const std::string_view destination)
+void FileManagerEmulator::setPathCacheCapacity(const std::size_t capacity)
 {
-    return validateAndTransferNode(source, destination, NodeTransferMode::Copy);
+    m_tree.setPathCacheCapacity(capacity);
 }
 
-bool FileManagerEmulator::md(const std::string_view dirAbsolutePath)
+void FileManagerEmulator::setResultLines(const bool resultLines)
 {
-    return validateAndCreateNode(NodeType::Directory, dirAbsolutePath, false);
+    m_resultLines = resultLines;
 }
 
-bool FileManagerEmulator::mf(const std::string_view fileAbsolutePath)
+void FileManagerEmulator::setTransactional(const bool transactional)
 {
-    return validateAndCreateNode(NodeType::File, fileAbsolutePath, true);
+    m_transactional = transactional;
 }
 
-bool FileManagerEmulator::mv(const std::string_view source, const std::string_view destination)
+void FileManagerEmulator::setTreeOutput(const TreeOutput treeOutput)
 {
-    return validateAndTransferNode(source, destination, NodeTransferMode::Move);
+    m_treeOutput = treeOutput;
 }
 
-bool FileManagerEmulator::rm(const std::string_view absolutePath)
+bool FileManagerEmulator::saveSnapshot(const std::string_view snapshotPath) const
 {
-    const auto normalizedPath = normalizePath(absolutePath);
-    const auto nodePathInfo   = getNodePathInfo(normalizedPath);
-    const auto parent         = findNodeByPath(nodePathInfo.path);
+    auto stream = std::ofstream(std::string{snapshotPath}, std::ofstream::out | std::ofstream::binary);
+    if (!stream.is_open())
+    {
+        m_logger->log<LogLevel::Error>("{}: {}. {}", snapshotPath, snapshotErrorToString(SnapshotError::CannotOpenFile),
+                                       std::strerror(errno));
+        return false;
+    }
 
-    if (parent)
+    const auto error = m_tree.saveSnapshot(stream);
+    if (error != SnapshotError::NoError)
     {
-        if (parent->children.contains(nodePathInfo.basename))
-        {
-            parent->children.erase(nodePathInfo.basename);
-            m_logger->logInfo(std::format("The item {} is removed.", normalizedPath));
-            return true;
-        }
-        else
-        {
-            m_logger->logError(std::format("No such item {}.", normalizedPath));
-        }
+        m_logger->log<LogLevel::Error>("{}: {}.", snapshotPath, snapshotErrorToString(error));
+        return false;
     }
 
-    return false;
+    m_logger->log<LogLevel::Info>("The snapshot {} is saved.", snapshotPath);
+    return true;
 }
 
-ErrorCode FileManagerEmulator::executeCommand(const Command& command)
+void FileManagerEmulator::setFastExit(const bool fastExit)
 {
-    if (!validateNumberOfCommandArguments(command))
-    {
-        return ErrorCode::CommandArgumentsError;
-    }
+    m_tree.setFastExit(fastExit);
+}
 
-    const auto ok = [this, &command]()
-    {
-        switch (command.name)
-        {
-            case CommandName::Cp:
-                return cp(command.arguments[0], command.arguments[1]);
-            case CommandName::Md:
-                return md(command.arguments[0]);
-            case CommandName::Mf:
-                return mf(command.arguments[0]);
-            case CommandName::Mv:
-                return mv(command.arguments[0], command.arguments[1]);
-            case CommandName::Rm:
-                return rm(command.arguments[0]);
-            default:
-                return false;
-        }
-    }();
+void FileManagerEmulator::setMetricsEnabled(const bool enabled)
+{
+    m_collectMetrics = metricsEnabled && enabled;
+    m_logger->setCollectStatistics(m_collectMetrics);
+    m_tree.setCountLookups(m_collectMetrics);
+}
 
-    return ok ? ErrorCode::NoError : ErrorCode::LogicError;
+void FileManagerEmulator::setPipelined(const bool pipelined)
+{
+    m_pipelined = pipelined;
 }
 
-FileManagerEmulator::FsNode* FileManagerEmulator::findNodeByPath(const std::string_view normalizedNodePath) const
+FsTree& FileManagerEmulator::tree() noexcept
 {
-    const auto findNextDelimiter = [normalizedNodePath](const std::size_t startPos)
-    {
-        return normalizedNodePath.find_first_of(pathDelimiter, startPos);
-    };
+    return m_tree;
+}
 
-    auto startPos = std::size_t{0}, delimiterPos = findNextDelimiter(0);
-    auto currentNode = m_fsRoot.get();
-    auto nodeName    = std::string{};
+bool FileManagerEmulator::begin()
+{
+    m_tree.beginTransaction();
+    m_logger->log<LogLevel::Info>("The transaction is started.");
+    return true;
+}
 
-    if (delimiterPos == std::string::npos)
+bool FileManagerEmulator::commit()
+{
+    // The transaction of the batch is committed only by the end of the run
+    if (m_tree.transactionDepth() <= (m_batchTransaction ? 1U : 0U))
     {
-        nodeName = normalizedNodePath;
+        m_logger->log<LogLevel::Error>("There is no transaction to commit.");
+        return false;
     }
-    else
-    {
-        for (; delimiterPos != std::string::npos; delimiterPos = findNextDelimiter(startPos))
-        {
-            nodeName = normalizedNodePath.substr(startPos, delimiterPos - startPos);
-
-            if (!nodeName.empty())
-            {
-                currentNode = getChildNode(currentNode, nodeName, normalizedNodePath);
-
-                if (!currentNode)
-                {
-                    return nullptr;
-                }
-            }
-
-            startPos = delimiterPos + 1;
-        }
-
-        nodeName = normalizedNodePath.substr(startPos, normalizedNodePath.length() - startPos);
+    m_logger->log<LogLevel::Info>("The transaction is committed with {} changes.", m_tree.commitTransaction());
+    return true;
+}
 
-        if (nodeName.empty() && !currentNode->isDirectory)
-        {
-            // File path with trailing slash is an invalid file reference.
-            m_logger->logError(formatInvalidFileReferenceErrorMsg(normalizedNodePath, currentNode->name));
-            return nullptr;
-        }
-    }
+bool FileManagerEmulator::cp(const std::string_view source, const std::string_view destination)
+{
+    return logResult(CommandName::Cp, m_tree.cp(source, destination));
+}
 
-    return nodeName.empty() ? currentNode : getChildNode(currentNode, nodeName, normalizedNodePath);
+bool FileManagerEmulator::du(const std::string_view path)
+{
+    return logResult(CommandName::Du, m_tree.du(path));
 }
 
-bool FileManagerEmulator::initCommandParser(const std::string_view batchFilePath)
+bool FileManagerEmulator::md(const std::string_view dirAbsolutePath)
 {
-    if (!batchFilePath.empty())
-    {
-        m_fileInStream = std::ifstream(std::string{batchFilePath}, std::ifstream::in);
+    return logResult(CommandName::Md, m_tree.md(dirAbsolutePath));
+}
 
-        if (m_fileInStream.is_open())
-        {
-            m_logger->logInfo(std::format("The batch file {} is opened.", batchFilePath));
-            m_parser = std::make_unique<CommandParser>(m_fileInStream);
-        }
-        else
-        {
-            m_logger->logError(std::format("{}: {}. {}", batchFilePath, "Cannot open the batch file for reading",
-                                           std::strerror(errno)));
-            return false;
-        }
-    }
-    else
-    {
-        m_logger->logInfo("The batch file is not provided. Reading standard input...");
-        m_parser = std::make_unique<CommandParser>(std::cin);
-    }
+bool FileManagerEmulator::mf(const std::string_view fileAbsolutePath)
+{
+    return logResult(CommandName::Mf, m_tree.mf(fileAbsolutePath));
+}
 
-    return m_parser != nullptr;
+bool FileManagerEmulator::mv(const std::string_view source, const std::string_view destination)
+{
+    return logResult(CommandName::Mv, m_tree.mv(source, destination));
 }
 
-bool FileManagerEmulator::isRootDirectory(const std::string_view path, const std::string_view basename) const
+bool FileManagerEmulator::rm(const std::string_view absolutePath)
 {
-    return path == m_fsRoot->name && basename.empty();
+    return logResult(CommandName::Rm, m_tree.rm(absolutePath));
 }
 
-FileManagerEmulator::FsNode* FileManagerEmulator::getChildNode(const FsNode* node, const std::string& childName,
-                                                               const std::string_view normalizedNodePath) const
+ErrorCode FileManagerEmulator::executeCommand(const Command& command)
 {
-    if (!node)
-    {
-        m_logger->logError(formatPathErrorMsg(normalizedNodePath, "null node is passed."));
-        return nullptr;
-    }
-    if (!node->isDirectory)
-    {
-        m_logger->logError(formatPathErrorMsg(normalizedNodePath, node->name + " is not a directory."));
-        return nullptr;
-    }
-    if (!node->children.contains(childName))
+    if (!validateNumberOfCommandArguments(command))
     {
-        m_logger->logError(formatPathErrorMsg(normalizedNodePath,
-                                              node->name + " does not contain the item " + childName + "."));
-        return nullptr;
+        return ErrorCode::CommandArgumentsError;
     }
 
-    return node->children.at(childName).get();
+    // The unquoted source with the wildcards is matched in one walk, md and mf take the wildcards literally
+    using Handler = bool (*)(FileManagerEmulator& emulator, const Command& command);
+    static constexpr auto handlers = makeCommandHandlers(std::array{
+      CommandHandler<Handler>{CommandName::Begin,
+                              [](FileManagerEmulator& emulator, const Command&) { return emulator.begin(); }},
+      CommandHandler<Handler>{CommandName::Commit,
+                              [](FileManagerEmulator& emulator, const Command&) { return emulator.commit(); }},
+      CommandHandler<Handler>{CommandName::Cp,
+                              [](FileManagerEmulator& emulator, const Command& command)
+                              {
+                                  const auto& [source, destination] = command.arguments;
+                                  return command.patterns[0]
+                                         ? emulator.logResult(command.name,
+                                                              emulator.m_tree.cpMatching(source, destination))
+                                         : emulator.cp(source, destination);
+                              }},
+      CommandHandler<Handler>{CommandName::Du, [](FileManagerEmulator& emulator, const Command& command)
+                              { return emulator.du(command.arguments[0]); }},
+      CommandHandler<Handler>{CommandName::Md, [](FileManagerEmulator& emulator, const Command& command)
+                              { return emulator.md(command.arguments[0]); }},
+      CommandHandler<Handler>{CommandName::Mf, [](FileManagerEmulator& emulator, const Command& command)
+                              { return emulator.mf(command.arguments[0]); }},
+      CommandHandler<Handler>{CommandName::Mv,
+                              [](FileManagerEmulator& emulator, const Command& command)
+                              {
+                                  const auto& [source, destination] = command.arguments;
+                                  return command.patterns[0]
+                                         ? emulator.logResult(command.name,
+                                                              emulator.m_tree.mvMatching(source, destination))
+                                         : emulator.mv(source, destination);
+                              }},
+      CommandHandler<Handler>{CommandName::Rm, [](FileManagerEmulator& emulator, const Command& command)
+                              {
+                                  return command.patterns[0]
+                                         ? emulator.logResult(command.name,
+                                                              emulator.m_tree.rmMatching(command.arguments[0]))
+                                         : emulator.rm(command.arguments[0]);
+                              }}
+    });
+
+    const auto ok = handlers[static_cast<std::size_t>(command.name)](*this, command);
+    return ok ? ErrorCode::NoError : ErrorCode::LogicError;
 }
 
-FileManagerEmulator::PathInfo FileManagerEmulator::getNodePathInfo(std::string_view normalizedNodeAbsolutePath,
-                                                                   const NodeType   requiredNodeType) const
+ErrorCode FileManagerEmulator::finishTransactions(ErrorCode code)
 {
-    auto result = PathInfo{};
-
-    if (normalizedNodeAbsolutePath.empty())
-    {
-        //  Empty path is considered as the root
-        result.type = NodeType::Directory;
-        result.path = pathDelimiter;
-        return result;
-    }
-
-    const auto pathHasTrailingSlash = normalizedNodeAbsolutePath.back() == pathDelimiter;
-    if (pathHasTrailingSlash)
+    if (code == ErrorCode::NoError && m_tree.transactionDepth() > (m_batchTransaction ? 1U : 0U))
     {
-        normalizedNodeAbsolutePath.remove_suffix(1);
+        m_logger->log<LogLevel::Error>("The transaction isn't committed at the end of the batch.");
+        code = ErrorCode::LogicError;
     }
 
-    // Find last slash
-    const auto pos = normalizedNodeAbsolutePath.find_last_of(pathDelimiter);
-
-    if (pos == std::string::npos)
-    {
-        // No slash -> everything is basename, path is root
-        result.path     = pathDelimiter;
-        result.basename = normalizedNodeAbsolutePath;
-    }
-    else if (pos == 0)
+    if (code != ErrorCode::NoError)
     {
-        // Path is root "/"
-        result.path     = pathDelimiter;
-        result.basename = normalizedNodeAbsolutePath.substr(1);
+        // The transactions are rolled back from the innermost one, their commands are never journaled
+        auto changes = std::size_t{0};
+        if (m_tree.transactionDepth() != 0)
+        {
+            while (m_tree.transactionDepth() != 0)
+            {
+                changes += m_tree.rollbackTransaction();
+            }
+            m_logger->log<LogLevel::Warning>("The {} changes of the failed transaction are rolled back.", changes);
+        }
+        m_transactionCommands.clear();
     }
-    else
+    else if (m_batchTransaction)
     {
-        result.path     = normalizedNodeAbsolutePath.substr(0, pos);
-        result.basename = normalizedNodeAbsolutePath.substr(pos + 1);
+        m_tree.commitTransaction();
+        if (m_journal && !m_transactionCommands.empty())
+        {
+            m_transactionCommands.pop_back();  // The separator of the last command
+            if (!journalCommands(m_transactionCommands))
+            {
+                code = ErrorCode::JournalError;
+            }
+        }
+        m_transactionCommands.clear();
     }
+    m_batchTransaction = false;
+    return code;
+}
 
-    if (pathHasTrailingSlash && requiredNodeType == NodeType::File)
-    {
-        // For example, /d1/f1.t/ is Invalid, if f1 is a file
-        //              /d1/f1/ is Invalid too, if f1 is a file
-        result.basename += pathDelimiter;
-        result.type      = NodeType::Invalid;
-    }
-    else
+bool FileManagerEmulator::journalCommand(const std::string_view commandString)
+{
+    if (m_tree.transactionDepth() != 0)
     {
-        // This is a "rough" guess about the file type based on the presence of '.',
-        // since dirs can also have '.' in their names.
-        result.type = isFilename(result.basename) ? NodeType::File : NodeType::Directory;
+        m_transactionCommands.append(commandString).push_back('\n');
+        return true;
     }
-
-    if (result.path.empty())
+    if (m_transactionCommands.empty())
     {
-        result.path = pathDelimiter;
+        return journalCommands(commandString);
     }
 
-    return result;
+    // The commit of the outermost block journals the block
+    m_transactionCommands.append(commandString);
+    const auto journaled = journalCommands(m_transactionCommands);
+    m_transactionCommands.clear();
+    return journaled;
 }
 
-std::string FileManagerEmulator::normalizePath(std::string_view nodePath) const
+bool FileManagerEmulator::journalCommands(const std::string_view commands)
 {
-    // "//", "/   /" etc. inside of the path are considered as the current node.
-    // "dir1//dir2" and "dir1/   /dir2" are valid path and result is "dir1/dir2".
-
-    if (nodePath.empty())
-    {
-        return std::string{pathDelimiter};
-    }
-
-    auto result = std::string{};
-    result.reserve(nodePath.size() + 1);
-
-    const auto findNextDelimiter = [nodePath](const std::size_t startPos)
-    {
-        return nodePath.find_first_of(pathDelimiter, startPos);
-    };
-
-    auto startPos = std::size_t{0}, delimiterPos = findNextDelimiter(0);
-    auto nodeName = std::string{};
-
-    if (delimiterPos == std::string::npos)
+    // The checkpoint is written only after the whole group, since the tree has already all its changes
+    for (auto start = std::size_t{0}; start <= commands.size();)
     {
-        // No slash -> everything is basename, path is root
-        result = std::string{nodePath};
-        trim(result);
-        result = pathDelimiter + result;
-    }
-    else
-    {
-        for (; delimiterPos != std::string::npos; delimiterPos = findNextDelimiter(startPos))
+        const auto end = findByteOf(commands, ByteClass::Newline, start);
+        if (!m_journal->append(commands.substr(start, end - start)))
         {
-            nodeName = std::string{nodePath.substr(startPos, delimiterPos - startPos)};
-            trim(nodeName);
-
-            if (!nodeName.empty())
-            {
-                result.append(pathDelimiter + nodeName);
-            }
-
-            startPos = delimiterPos + 1;
+            m_logger->log<LogLevel::Error>("{}: Cannot write the journal file.", m_journal->path());
+            return false;
         }
+        ++m_commandsSinceCheckpoint;
+        start = end + 1;
+    }
 
-        nodeName = std::string{nodePath.substr(startPos, nodePath.length() - startPos)};
-        trim(nodeName);
-
-        if (nodeName.empty())
-        {
-            // If entered path contains trailing /, we want to keep it
-            result.push_back(pathDelimiter);
-        }
-        else
+    if (m_checkpointInterval != 0 && m_commandsSinceCheckpoint >= m_checkpointInterval)
+    {
+        m_commandsSinceCheckpoint = 0;
+        const auto error          = m_journal->writeCheckpoint(m_tree.root());
+        if (error != SnapshotError::NoError)
         {
-            result.append(pathDelimiter + nodeName);
+            m_logger->log<LogLevel::Error>("{}: {}.", m_journal->checkpointPath(), snapshotErrorToString(error));
+            return false;
         }
     }
-
-    return result;
+    return true;
 }
 
-bool FileManagerEmulator::transferNode(const NodeType requiredNodeType, FileManagerEmulator::FsNode* const parentS,
-                                       FileManagerEmulator::FsNode* const parentD, const std::string_view source,
-                                       const std::string_view destination, const std::string& basenameS,
-                                       const std::string& basenameD, const std::string_view pathD,
-                                       const bool ignoreIfAlreadyExist, const NodeTransferMode transferMode)
+ErrorCode FileManagerEmulator::processCommand(const Command& command, const bool logCommand)
 {
-    // If destination is "/" (no basename), we must move in the root with the current name.
-    const auto nameAfterTransfer = basenameD.empty() ? basenameS : basenameD;
-    const auto destinationPath   = basenameD.empty() ? destination : pathD;  // path is destination without basename
-    const auto nodeTypeStr       = nodeTypeToString(requiredNodeType);
+    const auto start         = m_collectMetrics ? metricsNow() : std::chrono::steady_clock::time_point{};
+    const auto loggingBefore = m_logger->statistics().loggingTime;
 
-    if (!parentD->isDirectory)
+    if (logCommand && command.name != CommandName::Unknown)
     {
-        m_logger
-          ->logError(std::format("Cannot {} source {} {} in destination {} because destination is not a "
-                                 "directory.",
-                                 nodeTransferModeToString(transferMode), nodeTypeStr, source, destinationPath));
-        return false;
+        m_logger->log<LogLevel::Info>("Executing command [{}] ...", command.commandString);
     }
 
-    if (!parentD->children.contains(nameAfterTransfer))
+    if (command.name == CommandName::Unknown)
     {
-        if (transferMode == NodeTransferMode::Move)
+        if (command.hasError())
         {
-            parentD->children.insert({nameAfterTransfer, std::move(parentS->children.at(basenameS))});
-            parentD->children.at(nameAfterTransfer)->name = nameAfterTransfer;
-            parentS->children.erase(basenameS);
-            m_logger->logInfo(std::format("The {} {} is moved in {} with name {}.", nodeTypeStr, source,
-                                          destinationPath, nameAfterTransfer));
+            m_logger->log<LogLevel::Error>("{}{}", m_parser->errorToString(command.error.code), command.errorPart());
         }
         else
         {
-            auto newNode = parentS->children.at(basenameS)->copy(nameAfterTransfer);
-            parentD->children.insert({nameAfterTransfer, std::move(newNode)});
-            m_logger->logInfo(std::format("The {} {} is copied in {} with name {}.", nodeTypeStr, source,
-                                          destinationPath, nameAfterTransfer));
+            m_logger->log<LogLevel::Error>("Uknown command is met.");
         }
-        return true;
+        return ErrorCode::CommandParsingError;
     }
-    else
+    else if (command.hasError())
     {
-        if (ignoreIfAlreadyExist)
-        {
-            m_logger
-              ->logInfo(std::format("Ignore {} of {} {} in {} because the item with such a name already exists in "
-                                    "the {}.",
-                                    nodeTransferModeToString(transferMode), nodeTypeStr, source, destinationPath,
-                                    destinationPath));
-            return true;
-        }
-        else
-        {
-            m_logger
-              ->logError(std::format("Cannot {} {} {} in {} because the item with such a name already exists in {}.",
-                                     nodeTransferModeToString(transferMode), nodeTypeStr, source, destinationPath,
-                                     destinationPath));
-            return false;
-        }
+        m_logger->log<LogLevel::Error>("[{}] {}", command.commandString, m_parser->errorToString(command.error.code));
+        return ErrorCode::CommandParsingError;
     }
-    return false;
-}
 
-bool FileManagerEmulator::validateAndCreateNode(const NodeType         requiredNodeType,
-                                                const std::string_view nodeAbsolutePath,
-                                                const bool             ignoreIfAlreadyExist)
-{
-    const auto normalizedNodePath          = normalizePath(nodeAbsolutePath);
-    const auto& [path, basename, nodeType] = getNodePathInfo(normalizedNodePath, requiredNodeType);
-
-    if (requiredNodeType == NodeType::File && nodeType == NodeType::Invalid)
-    {
-        // File can have basename without '.'
-        // Directory can have basename with '.'
-        // Wrong is file "f.txt/" or "f/"
-        m_logger->logError(formatInvalidFileReferenceErrorMsg(normalizedNodePath, basename));
-        return false;
-    }
-    if (basename.empty())
+    const auto resultCode = executeCommand(command);
+    m_tree.reclaim(reclaimSliceSize);
+    if (resultCode == ErrorCode::NoError && m_journal && !journalCommand(command.commandString))
     {
-        m_logger->logError(formatPathErrorMsg(normalizedNodePath, "basename cannot be empty."));
-        return false;
+        return ErrorCode::JournalError;
     }
 
-    const auto parent = findNodeByPath(path);
-    if (!parent)
+    if constexpr (metricsEnabled)
     {
-        return false;
-    }
-    if (!parent->isDirectory)
-    {
-        m_logger->logError(formatPathErrorMsg(normalizedNodePath, std::format("{} is not a directory.", parent->name)));
-        return false;
+        if (m_collectMetrics)
+        {
+            // The logging time is measured by the logger, so the execution is the rest of the handling
+            const auto total   = std::chrono::steady_clock::now() - start;
+            const auto logging = m_logger->statistics().loggingTime - loggingBefore;
+            m_metrics.latency(command.name, CommandPhase::Execute).add(total - logging);
+            m_metrics.latency(command.name, CommandPhase::Log).add(logging);
+        }
     }
+    return resultCode;
+}
 
-    const auto nodeTypeStr = nodeTypeToString(requiredNodeType);
-
-    if (!parent->children.contains(basename))
-    {
-        auto newNode = std::unique_ptr<FsNode>{
-          new FsNode{.name = basename, .isDirectory = requiredNodeType == NodeType::Directory, .children = {}}
-        };
-        parent->children.insert({basename, std::move(newNode)});
-        m_logger->logInfo(std::format("The {} {} is created.", nodeTypeStr, normalizedNodePath));
-    }
-    else
+void FileManagerEmulator::recordLatency(const CommandName name, const CommandPhase phase,
+                                        const std::chrono::steady_clock::time_point start)
+{
+    if constexpr (metricsEnabled)
     {
-        if (ignoreIfAlreadyExist)
-        {
-            m_logger
-              ->logInfo(std::format("Ignore creation of the {} {} because the item with such a name already exists.",
-                                    nodeTypeStr, normalizedNodePath));
-        }
-        else
+        if (m_collectMetrics)
         {
-            m_logger->logError(std::format("Cannot create {} {}: parent directory {} already contains item {}.",
-                                           nodeTypeStr, normalizedNodePath, path, basename));
-            return false;
+            m_metrics.latency(name, phase).add(std::chrono::steady_clock::now() - start);
         }
     }
-
-    return parent;
 }
 
-bool FileManagerEmulator::validateAndTransferNode(const std::string_view s, const std::string_view d,
-                                                  const NodeTransferMode transferMode)
+bool FileManagerEmulator::resumeJournal()
 {
-    const auto source = normalizePath(s), destination = normalizePath(d);
-    const auto& [pathS, basenameS, nodeTypeS] = getNodePathInfo(source);
-    const auto& [pathD, basenameD, nodeTypeD] = getNodePathInfo(destination);
-    const auto destinationIsRoot              = isRootDirectory(pathD, basenameD);
-    // mv d1/d2 /   - basenameD is empty, so we say that newBasenameD = basenameS
-    const auto newBasenameD                   = destinationIsRoot ? basenameS : basenameD;
+    const auto& journalPath = m_journal->path();
+    auto        checkpoint  = CommandJournal::Checkpoint{};
+    auto        fsError     = std::error_code{};
 
-    if (isRootDirectory(pathS, basenameS))
-    {
-        m_logger->logError(std::format("Cannot {} the root directory.", nodeTransferModeToString(transferMode)));
-        return false;
-    }
-    if (basenameS.empty() || newBasenameD.empty())
-    {
-        m_logger->logError(formatPathErrorMsg(basenameS.empty() ? source : destination, "basename cannot be empty."));
-        return false;
-    }
-    if ((pathS == pathD && basenameS == basenameD) || (pathS == std::string{pathDelimiter} && destinationIsRoot))
+    if (std::filesystem::exists(m_journal->checkpointPath(), fsError))
     {
-        // m_logger->logError(std::string{"Cannot move the item into itself."});
-        // return false;
-
-        // Ignore moving item into itself.
-        return true;
+        auto       root  = FsNodePtr{};
+        const auto error = m_journal->readCheckpoint(m_tree.storage(), root, checkpoint);
+        if (error != SnapshotError::NoError)
+        {
+            m_logger->log<LogLevel::Error>("{}: {}.", m_journal->checkpointPath(), snapshotErrorToString(error));
+            return false;
+        }
+        m_tree.replaceRoot(std::move(root));
     }
 
-    auto sourceWithoutSlash = std::string_view{source};
-    if (sourceWithoutSlash.back() == pathDelimiter)
+    // The journal is read as a batch file, only its complete lines after the checkpoint are replayed
+    auto journalFile = MappedFile{};
+    auto content     = std::string{};
+    auto data        = std::string_view{};
+    if (journalFile.open(journalPath))
     {
-        sourceWithoutSlash.remove_suffix(1);
+        data = journalFile.data();
     }
-    if (destination.starts_with(sourceWithoutSlash) && destination.length() > sourceWithoutSlash.length()
-        && destination.at(sourceWithoutSlash.length()) == pathDelimiter)
+    else if (auto stream = std::ifstream(journalPath, std::ifstream::in | std::ifstream::binary); stream.is_open())
     {
-        // Checks that, for example, /d1 is a subdirectory of /d1/d2 and not a subdirectory of /d11/d2
-        m_logger->logError(std::format("Cannot {} the element {} into own subdirectory {}.",
-                                       nodeTransferModeToString(transferMode), source, destination));
-        return false;
+        content.assign(std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{});
+        data = content;
     }
 
-    const auto parentS = findNodeByPath(pathS);
-    if (!parentS)
+    if (checkpoint.journalSize > data.size())
     {
+        m_logger->log<LogLevel::Error>("{}: The journal doesn't match the checkpoint.", journalPath);
         return false;
     }
-    if (!parentS->children.contains(basenameS))
+    const auto tail     = data.substr(checkpoint.journalSize);
+    const auto complete = tail.substr(0, tail.rfind('\n') + 1);
+
+    // The replayed commands were already reported in the journaled run
+    auto       parser     = CommandParser{complete};
+    auto       replayed   = std::uint64_t{0};
+    auto       resultCode = ErrorCode::NoError;
+    const auto minLevel   = m_logger->minLevel();
+    m_logger->setMinLevel(LogLevel::Off);
+    while (resultCode == ErrorCode::NoError && parser.hasMoreInput())
     {
-        m_logger->logError(std::format("No such {} {}.", nodeTypeToString(nodeTypeS), source));
-        return false;
+        const auto command = parser.getNextCommand();
+        resultCode         = command.hasError() ? ErrorCode::CommandParsingError : executeCommand(command);
+        m_tree.reclaim(reclaimSliceSize);
+        replayed += resultCode == ErrorCode::NoError ? 1 : 0;
     }
+    m_logger->setMinLevel(minLevel);
 
-    auto parentD = findNodeByPath(pathD);
-    if (!parentD)
+    // The blocks are journaled on their commit, so only the interrupted writing leaves the block open
+    if (resultCode == ErrorCode::NoError && m_tree.transactionDepth() != 0)
     {
+        m_logger->log<LogLevel::Error>("{}: The journal ends inside of the transaction.", journalPath);
         return false;
     }
-    if (parentS == parentD && basenameS == newBasenameD)
+    if (resultCode != ErrorCode::NoError)
     {
-        return true;
+        m_logger->log<LogLevel::Error>("{}: The command {} of the journal cannot be replayed.", journalPath,
+                                       replayed + 1);
+        return false;
     }
-    if (!parentD->isDirectory)
+    if (!m_journal->continueAt(checkpoint.journalSize + complete.size(), checkpoint.commandsNumber + replayed))
     {
-        m_logger
-          ->logError(std::format("Cannot {} the item {} in destination {} because destination is not a "
-                                 "directory.",
-                                 nodeTransferModeToString(transferMode), source, pathD));
+        m_logger->log<LogLevel::Error>("{}: Cannot open the journal file. {}", journalPath, std::strerror(errno));
         return false;
     }
 
-    const auto sourceIsDir = parentS->children.at(basenameS)->isDirectory;
-    if (!sourceIsDir)
+    m_skippedCommandsNumber = m_journal->commandsNumber();
+    m_logger->log<LogLevel::Info>("The journal {} is resumed: {} commands are restored ({} from the checkpoint).",
+                                  journalPath, m_skippedCommandsNumber, checkpoint.commandsNumber);
+    return true;
+}
+
+ErrorCode FileManagerEmulator::runPipelined(const bool logCommands)
+{
+    // The parser thread is the only user of the parser state and of the input, the executor (this thread)
+    // is the only user of the tree and of the logger. The commands read from the stream refer to the line buffer
+    // of the parser, so they are rebased onto the ring of lines. The ring is larger than the queue, so a line is
+    // overwritten only after its command is executed. The commands read from the memory stay valid as they are.
+    auto commands    = SpscQueue<Command>{pipelineCapacity};
+    auto lines       = std::vector<std::string>(m_readsMemory ? 0 : pipelineCapacity + 2);
+    auto parserError = std::exception_ptr{};
+
+    const auto parseAhead = [this, &commands, &lines, &parserError]()
     {
-        if (source.back() == pathDelimiter)
+        try
         {
-            // Wrong basename of the source file.
-            m_logger->logError(formatInvalidFileReferenceErrorMsg(source, basenameS + pathDelimiter));
-            return false;
+            for (auto lineIndex = std::size_t{0}; m_parser->hasMoreInput();)
+            {
+                auto command = m_parser->getNextCommand();
+                if (!lines.empty())
+                {
+                    auto& line = lines[lineIndex];
+                    lineIndex  = (lineIndex + 1) % lines.size();
+                    line.assign(command.commandString);
+                    command = command.rebased(line);
+                }
+                if (!commands.push(command))
+                {
+                    break;  // The executor has stopped on the error
+                }
+            }
         }
-    }
+        catch (...)
+        {
+            parserError = std::current_exception();
+        }
+        commands.close();
+    };
 
-    const auto requiredNodeType     = sourceIsDir ? NodeType::Directory : NodeType::File;
-    const auto ignoreIfAlreadyExist = sourceIsDir ? false : true;
+    auto parserThread = std::thread{parseAhead};
 
-    if (parentD->children.contains(newBasenameD) && !destinationIsRoot)
+    auto resultCode = ErrorCode::NoError;
+    try
     {
-        // For example, we have d3/d1. After we mv d3/d1 /  .
-        // This must move d1 from d3 into the root folder.
-        // If basenameD == newBasenameD -> the destination path is like /d1 - move d3/d1 into /d1
-        // If basenameD != newBasenameD -> the destination path is like / - move d3/d1 into /
-        // So, in case basenameD != newBasenameD we must prevent replacing of parent root with
-        // it child d1.
-        parentD = parentD->children.at(newBasenameD).get();
+        auto command = Command{};
+        while (resultCode == ErrorCode::NoError && commands.pop(command))
+        {
+            resultCode = processCommand(command, logCommands);
+            writeResultLine(command, resultCode);
+        }
+    }
+    catch (...)
+    {
+        commands.cancel();
+        parserThread.join();
+        throw;
+    }
+
+    commands.cancel();
+    parserThread.join();
 
-        // Move with the same name
-        return transferNode(requiredNodeType, parentS, parentD, source, destination, basenameS, "", pathD,
-                            ignoreIfAlreadyExist, transferMode);
+    if (resultCode == ErrorCode::NoError && parserError)
+    {
+        // All commands parsed before the failure are executed, as in the sequential mode
+        std::rethrow_exception(parserError);
     }
-    else
+    return resultCode;
+}
+
+bool FileManagerEmulator::initCommandParser(const std::string_view batchFilePath)
+{
+    if (!batchFilePath.empty())
     {
-        if (!sourceIsDir && destination.back() == pathDelimiter && !destinationIsRoot)
+        // Regular files are mapped into the memory and parsed without copying,
+        // other files (for example, named pipes) are read via the stream.
+        auto batchFile = std::make_unique<MappedFile>();
+
+        if (batchFile->open(batchFilePath))
+        {
+            m_logger->log<LogLevel::Info>("The batch file {} is opened.", batchFilePath);
+            m_batchFile   = std::move(batchFile);
+            m_parser      = std::make_unique<CommandParser>(m_batchFile->data());
+            m_readsMemory = true;
+            return true;
+        }
+
+        m_fileInStream = std::ifstream(std::string{batchFilePath}, std::ifstream::in);
+
+        if (m_fileInStream.is_open())
         {
-            // Wrong basename of the destination file.
-            m_logger->logError(formatInvalidFileReferenceErrorMsg(destination, basenameD + pathDelimiter));
+            m_logger->log<LogLevel::Info>("The batch file {} is opened.", batchFilePath);
+            m_parser = std::make_unique<CommandParser>(m_fileInStream);
+        }
+        else
+        {
+            m_logger->log<LogLevel::Error>("{}: {}. {}", batchFilePath, "Cannot open the batch file for reading",
+                                           std::strerror(errno));
             return false;
         }
+    }
+    else
+    {
+        m_logger->log<LogLevel::Info>("The batch file is not provided. Reading standard input...");
+        m_parser = CommandParser::canReadDescriptors() ? std::make_unique<CommandParser>(standardInputDescriptor)
+                                                       : std::make_unique<CommandParser>(std::cin);
+    }
+
+    return m_parser != nullptr;
+}
 
-        // Move and rename
-        return transferNode(requiredNodeType, parentS, parentD, source, destination, basenameS, newBasenameD, pathD,
-                            ignoreIfAlreadyExist, transferMode);
+bool FileManagerEmulator::logResult(const CommandName name, const FsResult& result)
+{
+    if (!result.ok())
+    {
+        logFailure(*m_logger, name, result);
+        return false;
     }
-    return false;
+    if (name == CommandName::Du)
+    {
+        m_duStats = result.stats;
+    }
+    logSuccess(*m_logger, name, result);
+    return true;
 }
 
 bool FileManagerEmulator::validateNumberOfCommandArguments(const Command& command) const
@@ -713,41 +1122,34 @@ bool FileManagerEmulator::validateNumberOfCommandArguments(const Command& comman
         return false;
     }
 
-    static const auto commandsArgumentNum = std::map<CommandName, std::size_t>{
-      {CommandName::Cp, 2},
-      {CommandName::Md, 1},
-      {CommandName::Mf, 1},
-      {CommandName::Mv, 2},
-      {CommandName::Rm, 1}
-    };
-
-    const auto numArgsToAccept = commandsArgumentNum.at(command.name);
-    const auto numPassedArgs   = command.arguments.size();
+    const auto numArgsToAccept = commandSpec(command.name).argumentsNumber;
+    const auto numPassedArgs   = command.argumentsNumber;
 
     if (numPassedArgs != numArgsToAccept)
     {
-        m_logger->logError(std::format("Command {} accepts {} argument(-s) (the number of passed arguments is {}).",
-                                       m_parser->commandNameToString(command.name), numArgsToAccept, numPassedArgs),
-                           command.commandString);
+        m_logger->log<LogLevel::Error>("[{}] Command {} accepts {} argument(-s) (the number of passed arguments is "
+                                       "{}).",
+                                       command.commandString, m_parser->commandNameToString(command.name),
+                                       numArgsToAccept, numPassedArgs);
         return false;
     }
 
     return true;
 }
 
-std::unique_ptr<FileManagerEmulator::FsNode> FileManagerEmulator::FsNode::copy(const std::string_view newName) const
+void FileManagerEmulator::writeResultLine(const Command& command, const ErrorCode code)
 {
-    auto newNode         = std::make_unique<FsNode>();
-    newNode->name        = newName.empty() ? name : newName;
-    newNode->isDirectory = isDirectory;
-
-    for (const auto& [childName, childPtr] : children)
+    if (!m_resultLines)
     {
-        if (childPtr)
-        {
-            newNode->children[childName] = childPtr->copy();
-        }
+        return;
     }
 
-    return newNode;
+    m_resultLine.clear();
+    std::format_to(std::back_inserter(m_resultLine), "RESULT: {}", static_cast<int>(code));
+    if (command.name == CommandName::Du && code == ErrorCode::NoError)
+    {
+        std::format_to(std::back_inserter(m_resultLine), " {} {} {}", m_duStats.files, m_duStats.directories,
+                       m_duStats.maxDepth);
+    }
+    m_logger->writeLine(m_resultLine);
 }
@@ -0,0 +1,108 @@
+#include "fme_metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <ostream>
+
+#include "command_parser.h"
+
+namespace
+{
+constexpr inline auto phaseNames      = std::array{"parse", "execute", "log"};
+constexpr inline auto percentileRanks = std::array{50.0, 99.0};
+
+}  // namespace
+
+void LatencyHistogram::add(const std::chrono::nanoseconds duration) noexcept
+{
+    const auto nanoseconds = static_cast<std::uint64_t>(duration.count() > 0 ? duration.count() : 0);
+    const auto bucket      = std::min(static_cast<std::size_t>(std::bit_width(nanoseconds)), bucketsNumber - 1);
+    ++m_buckets[bucket];
+    ++m_count;
+    m_total += duration;
+    m_max    = std::max(m_max, duration);
+}
+
+std::uint64_t LatencyHistogram::count() const noexcept
+{
+    return m_count;
+}
+
+std::chrono::nanoseconds LatencyHistogram::max() const noexcept
+{
+    return m_max;
+}
+
+std::chrono::nanoseconds LatencyHistogram::mean() const noexcept
+{
+    return m_count == 0 ? std::chrono::nanoseconds{} : m_total / static_cast<std::int64_t>(m_count);
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(const double percentile) const noexcept
+{
+    // The rank of the percentile is rounded up, so the 100th percentile is the last non-empty bucket
+    const auto rank = static_cast<std::uint64_t>(std::ceil(static_cast<double>(m_count) * percentile / 100.0));
+    auto       seen = std::uint64_t{0};
+    for (auto bucket = std::size_t{0}; bucket < bucketsNumber; ++bucket)
+    {
+        seen += m_buckets[bucket];
+        if (seen >= rank && seen != 0)
+        {
+            return std::min(std::chrono::nanoseconds{std::int64_t{1} << bucket}, m_max);
+        }
+    }
+    return m_max;
+}
+
+std::chrono::nanoseconds LatencyHistogram::total() const noexcept
+{
+    return m_total;
+}
+
+LatencyHistogram& Metrics::latency(const CommandName name, const CommandPhase phase) noexcept
+{
+    return latencies[static_cast<std::size_t>(name)][static_cast<std::size_t>(phase)];
+}
+
+const LatencyHistogram& Metrics::latency(const CommandName name, const CommandPhase phase) const noexcept
+{
+    return latencies[static_cast<std::size_t>(name)][static_cast<std::size_t>(phase)];
+}
+
+void writeMetricsReport(const Metrics& metrics, std::ostream& output)
+{
+    if constexpr (!metricsEnabled)
+    {
+        output << "The metrics are disabled at compile time (FME_METRICS=OFF)." << std::endl;
+        return;
+    }
+
+    const auto names = CommandParser{std::string_view{}};
+    output << std::format("{:<8} {:<8} {:>10} {:>12} {:>12} {:>12} {:>12} {:>14}\n", "command", "phase", "count",
+                          "mean, ns", "p50, ns", "p99, ns", "max, ns", "total, ms");
+    for (auto name = std::size_t{0}; name < Metrics::commandNamesNumber; ++name)
+    {
+        for (auto phase = std::size_t{0}; phase < Metrics::phasesNumber; ++phase)
+        {
+            const auto& histogram = metrics.latencies[name][phase];
+            if (histogram.count() == 0)
+            {
+                continue;
+            }
+            output << std::format("{:<8} {:<8} {:>10} {:>12} {:>12} {:>12} {:>12} {:>14.3f}\n",
+                                  names.commandNameToString(static_cast<CommandName>(name)), phaseNames[phase],
+                                  histogram.count(), histogram.mean().count(),
+                                  histogram.percentile(percentileRanks[0]).count(),
+                                  histogram.percentile(percentileRanks[1]).count(), histogram.max().count(),
+                                  static_cast<double>(histogram.total().count()) / 1e6);
+        }
+    }
+
+    output << std::format("Nodes: allocated {}, freed {}, peak {}\n", metrics.nodesAllocated, metrics.nodesFreed,
+                          metrics.peakNodes)
+           << std::format("Path components resolved {}, children lookups {}, bytes logged {}\n",
+                          metrics.pathComponentsResolved, metrics.childrenLookups, metrics.bytesLogged)
+           << std::flush;
+}
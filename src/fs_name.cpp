@@ -0,0 +1,141 @@
+#include "fs_name.h"
+
+#include <cstring>
+#include <new>
+#include <utility>
+
+FsName::FsName(const std::string_view name)
+{
+    if (name.size() <= maxInlineSize)
+    {
+        std::memcpy(m_chars.data(), name.data(), name.size());
+        m_tag = static_cast<std::uint8_t>(name.size());
+        return;
+    }
+
+    const auto memory = ::operator new(sizeof(LongName) + name.size());
+    const auto header = ::new (memory) LongName{.refCount = 1, .size = static_cast<std::uint32_t>(name.size())};
+    std::memcpy(header + 1, name.data(), name.size());
+    std::memcpy(m_chars.data(), &header, sizeof(header));
+    m_tag = longBit;
+}
+
+FsName::FsName(const FsName& other) noexcept : m_chars{other.m_chars}, m_tag{other.m_tag}
+{
+    if (const auto header = longName())
+    {
+        ++header->refCount;
+    }
+}
+
+FsName::FsName(FsName&& other) noexcept : m_chars{other.m_chars}, m_tag{std::exchange(other.m_tag, 0)}
+{
+}
+
+FsName::~FsName()
+{
+    release();
+}
+
+FsName& FsName::operator=(FsName other) noexcept
+{
+    std::swap(m_chars, other.m_chars);
+    std::swap(m_tag, other.m_tag);
+    return *this;
+}
+
+FsName& FsName::operator=(const std::string_view name)
+{
+    auto replacement  = FsName{name};
+    replacement.m_tag = static_cast<std::uint8_t>(replacement.m_tag | (m_tag & ~(sizeMask | longBit)));
+    return *this = std::move(replacement);
+}
+
+FsName::operator std::string_view() const noexcept
+{
+    return view();
+}
+
+bool operator==(const FsName& a, const FsName& b) noexcept
+{
+    // The copies share the long name, so the same header means the same name
+    return (a.longName() && a.longName() == b.longName()) || a.view() == b.view();
+}
+
+bool operator==(const FsName& a, const std::string_view b) noexcept
+{
+    return a.view() == b;
+}
+
+std::strong_ordering operator<=>(const FsName& a, const FsName& b) noexcept
+{
+    return a.view() <=> b.view();
+}
+
+std::strong_ordering operator<=>(const FsName& a, const std::string_view b) noexcept
+{
+    return a.view() <=> b;
+}
+
+const char* FsName::data() const noexcept
+{
+    const auto header = longName();
+    return header ? reinterpret_cast<const char*>(header + 1) : m_chars.data();
+}
+
+bool FsName::empty() const noexcept
+{
+    return size() == 0;
+}
+
+bool FsName::flag(const std::size_t index) const noexcept
+{
+    return (m_tag >> (flagsShift + index) & 1U) != 0;
+}
+
+const void* FsName::heapData() const noexcept
+{
+    return longName();
+}
+
+std::size_t FsName::heapSize() const noexcept
+{
+    const auto header = longName();
+    return header ? sizeof(LongName) + header->size : 0;
+}
+
+void FsName::setFlag(const std::size_t index, const bool value) noexcept
+{
+    const auto bit = static_cast<std::uint8_t>(1U << (flagsShift + index));
+    m_tag          = static_cast<std::uint8_t>(value ? m_tag | bit : m_tag & ~bit);
+}
+
+std::size_t FsName::size() const noexcept
+{
+    const auto header = longName();
+    return header ? header->size : m_tag & sizeMask;
+}
+
+std::string_view FsName::view() const noexcept
+{
+    return {data(), size()};
+}
+
+FsName::LongName* FsName::longName() const noexcept
+{
+    if ((m_tag & longBit) == 0)
+    {
+        return nullptr;
+    }
+    auto header = static_cast<LongName*>(nullptr);
+    std::memcpy(&header, m_chars.data(), sizeof(header));
+    return header;
+}
+
+void FsName::release() noexcept
+{
+    if (const auto header = longName(); header && --header->refCount == 0)
+    {
+        ::operator delete(header);
+    }
+}
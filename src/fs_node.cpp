@@ -0,0 +1,654 @@
+#include "fs_node.h"
+
+#include <algorithm>
+#include <new>
+#include <utility>
+
+namespace
+{
+// Directories with more children keep them in the search tree
+constexpr inline auto wideDirectoryMinSize = std::size_t{64};
+// Directories with less children keep them in the sorted vector. It's less than wideDirectoryMinSize
+// to avoid repeated conversions, when the number of children fluctuates around the bound.
+constexpr inline auto smallDirectoryMaxSize = std::size_t{32};
+
+const auto emptyChildren = FsChildren{};
+const auto emptyStats    = FsSubtreeStats{};
+
+// The depth of the deepest item of the child subtree below the parent of the child
+std::size_t heightBelowParent(const FsNode& child) noexcept
+{
+    return child.stats().maxDepth + 1;
+}
+
+// Replaces the height of one child in the aggregates of its parent, 0 stands for the absent child
+void replaceChildHeight(const FsNode& parent, FsSubtreeStats& stats, const std::size_t oldHeight,
+                        const std::size_t newHeight) noexcept
+{
+    if (oldHeight != 0 && oldHeight == stats.maxDepth)
+    {
+        --stats.deepestChildren;
+    }
+    if (newHeight > stats.maxDepth)
+    {
+        stats.maxDepth        = newHeight;
+        stats.deepestChildren = 1;
+    }
+    else if (newHeight != 0 && newHeight == stats.maxDepth)
+    {
+        ++stats.deepestChildren;
+    }
+
+    if (stats.deepestChildren == 0 && stats.maxDepth != 0)
+    {
+        // The last deepest child is gone, so the depth is found again from the aggregates of the children
+        stats.maxDepth = 0;
+        for (const auto& child : parent.children())
+        {
+            replaceChildHeight(parent, stats, 0, heightBelowParent(*child));
+        }
+    }
+}
+
+// Updates the aggregates of the directory and its ancestors after the insertion or removal of the child
+void updateAncestorsStats(FsNode* const directory, const FsNode& child, const bool isInserted) noexcept
+{
+    const auto& childStats  = child.stats();
+    const auto  files       = childStats.files + (child.isDirectory() ? 0 : 1);
+    const auto  directories = childStats.directories + (child.isDirectory() ? 1 : 0);
+    auto        oldHeight   = isInserted ? std::size_t{0} : heightBelowParent(child);
+    auto        newHeight   = isInserted ? heightBelowParent(child) : std::size_t{0};
+
+    // The ancestors are unshared, so their aggregates belong only to them
+    for (auto node = directory; node; node = node->parent)
+    {
+        auto& stats = node->directory->stats;
+        if (isInserted)
+        {
+            stats.files       += files;
+            stats.directories += directories;
+        }
+        else
+        {
+            stats.files       -= files;
+            stats.directories -= directories;
+        }
+
+        if (oldHeight != newHeight)
+        {
+            const auto oldMaxDepth = stats.maxDepth;
+            replaceChildHeight(*node, stats, oldHeight, newHeight);
+            oldHeight = oldMaxDepth + 1;
+            newHeight = stats.maxDepth + 1;
+        }
+    }
+}
+
+template<typename T, typename... Args>
+T* constructInAllocator(SlabAllocator& allocator, Args&&... args)
+{
+    const auto memory = allocator.allocate();
+
+    try
+    {
+        return ::new (memory) T{std::forward<Args>(args)...};
+    }
+    catch (...)
+    {
+        allocator.deallocate(memory);
+        throw;
+    }
+}
+
+}  // namespace
+
+void FsNodeDeleter::operator()(FsNode* const node) const noexcept
+{
+    if (node)
+    {
+        node->~FsNode();
+        allocator->deallocate(node);
+    }
+}
+
+bool FsChildren::NameLess::operator()(const FsNodePtr& a, const FsNodePtr& b) const noexcept
+{
+    return a->name < b->name;
+}
+
+bool FsChildren::NameLess::operator()(const FsNodePtr& a, const std::string_view b) const noexcept
+{
+    return a->name < b;
+}
+
+bool FsChildren::NameLess::operator()(const std::string_view a, const FsNodePtr& b) const noexcept
+{
+    return a < b->name;
+}
+
+FsChildren::const_iterator::const_iterator(Iterator it) : m_it{std::move(it)}
+{
+}
+
+FsChildren::const_iterator::reference FsChildren::const_iterator::operator*() const
+{
+    return std::visit(
+      [](const auto& it) -> reference
+      {
+          return *it;
+      },
+      m_it);
+}
+
+FsChildren::const_iterator::pointer FsChildren::const_iterator::operator->() const
+{
+    return &**this;
+}
+
+FsChildren::const_iterator& FsChildren::const_iterator::operator++()
+{
+    std::visit(
+      [](auto& it)
+      {
+          ++it;
+      },
+      m_it);
+    return *this;
+}
+
+FsChildren::const_iterator FsChildren::const_iterator::operator++(int)
+{
+    auto copy = *this;
+    ++*this;
+    return copy;
+}
+
+FsChildren::const_iterator FsChildren::begin() const noexcept
+{
+    return std::visit(
+      [](const auto& children)
+      {
+          return const_iterator{children.begin()};
+      },
+      m_children);
+}
+
+FsChildren::const_iterator FsChildren::end() const noexcept
+{
+    return std::visit(
+      [](const auto& children)
+      {
+          return const_iterator{children.end()};
+      },
+      m_children);
+}
+
+FsNode* FsChildren::childAt(const const_iterator position, const std::string_view name) const noexcept
+{
+    return position != end() && (*position)->name == name ? position->get() : nullptr;
+}
+
+bool FsChildren::contains(const std::string_view name) const noexcept
+{
+    return find(name) != nullptr;
+}
+
+bool FsChildren::empty() const noexcept
+{
+    return size() == 0;
+}
+
+bool FsChildren::erase(const std::string_view name)
+{
+    return extract(name) != nullptr;
+}
+
+FsNodePtr FsChildren::extract(const std::string_view name)
+{
+    const auto position = lowerBound(name);
+    return childAt(position, name) ? extract(position) : FsNodePtr{};
+}
+
+FsNodePtr FsChildren::extract(const const_iterator position)
+{
+    auto node = FsNodePtr{};
+
+    if (auto flat = std::get_if<FlatChildren>(&m_children))
+    {
+        const auto it = flat->begin() + (std::get<FlatChildren::const_iterator>(position.m_it) - flat->cbegin());
+        node          = std::move(*it);
+        flat->erase(it);
+    }
+    else
+    {
+        auto& tree = std::get<TreeChildren>(m_children);
+        node       = std::move(tree.extract(std::get<TreeChildren::const_iterator>(position.m_it)).value());
+    }
+
+    updateRepresentation();
+    return node;
+}
+
+void FsChildren::extractAll(std::vector<FsNodePtr>& nodes)
+{
+    if (auto flat = std::get_if<FlatChildren>(&m_children))
+    {
+        nodes.insert(nodes.end(), std::make_move_iterator(flat->begin()), std::make_move_iterator(flat->end()));
+    }
+    else
+    {
+        auto& tree = std::get<TreeChildren>(m_children);
+        nodes.reserve(nodes.size() + tree.size());
+        while (!tree.empty())
+        {
+            nodes.push_back(std::move(tree.extract(tree.begin()).value()));
+        }
+    }
+
+    m_children = FlatChildren{};
+}
+
+FsNode* FsChildren::find(const std::string_view name) const noexcept
+{
+    if (const auto flat = std::get_if<FlatChildren>(&m_children))
+    {
+        const auto it = std::lower_bound(flat->begin(), flat->end(), name, NameLess{});
+        return it != flat->end() && (*it)->name == name ? it->get() : nullptr;
+    }
+
+    const auto& tree = std::get<TreeChildren>(m_children);
+    const auto  it   = tree.find(name);
+    return it != tree.end() ? it->get() : nullptr;
+}
+
+std::size_t FsChildren::heapSize() const noexcept
+{
+    if (const auto flat = std::get_if<FlatChildren>(&m_children))
+    {
+        return flat->capacity() * sizeof(FsNodePtr);
+    }
+    // A node of the red-black tree keeps the color and three links besides the element
+    return std::get<TreeChildren>(m_children).size() * (sizeof(FsNodePtr) + 4 * sizeof(void*));
+}
+
+FsNode* FsChildren::insert(FsNodePtr node)
+{
+    const auto isAppended = std::visit(
+      [&node](const auto& children)
+      {
+          return children.empty() || (*children.rbegin())->name < node->name;
+      },
+      m_children);
+
+    // Fast path: the children are appended in ascending order (for example, during cloning)
+    auto position = end();
+    if (!isAppended)
+    {
+        position = lowerBound(node->name);
+        if ((*position)->name == node->name)
+        {
+            return nullptr;
+        }
+    }
+    return insert(position, std::move(node));
+}
+
+FsNode* FsChildren::insert(const const_iterator position, FsNodePtr node)
+{
+    const auto insertedNode = node.get();
+
+    if (auto flat = std::get_if<FlatChildren>(&m_children))
+    {
+        flat->insert(std::get<FlatChildren::const_iterator>(position.m_it), std::move(node));
+    }
+    else
+    {
+        // The position is the successor of the node, so the hint makes the insertion amortized constant
+        std::get<TreeChildren>(m_children).insert(std::get<TreeChildren::const_iterator>(position.m_it),
+                                                  std::move(node));
+    }
+
+    updateRepresentation();
+    return insertedNode;
+}
+
+FsChildren::const_iterator FsChildren::lowerBound(const std::string_view name) const noexcept
+{
+    if (const auto flat = std::get_if<FlatChildren>(&m_children))
+    {
+        return const_iterator{std::lower_bound(flat->begin(), flat->end(), name, NameLess{})};
+    }
+    return const_iterator{std::get<TreeChildren>(m_children).lower_bound(name)};
+}
+
+FsNode* FsChildren::rename(const const_iterator position, const const_iterator newPosition,
+                           const std::string_view newName)
+{
+    if (auto flat = std::get_if<FlatChildren>(&m_children))
+    {
+        const auto from = flat->begin() + (std::get<FlatChildren::const_iterator>(position.m_it) - flat->cbegin());
+        const auto to   = flat->begin() + (std::get<FlatChildren::const_iterator>(newPosition.m_it) - flat->cbegin());
+        const auto node = from->get();
+
+        // The order is restored by the rotation, which shifts only the children between the positions
+        node->name = newName;
+        if (from < to)
+        {
+            std::rotate(from, from + 1, to);
+        }
+        else
+        {
+            std::rotate(to, from, from + 1);
+        }
+        return node;
+    }
+
+    auto&      tree = std::get<TreeChildren>(m_children);
+    const auto from = std::get<TreeChildren::const_iterator>(position.m_it);
+    auto       hint = std::get<TreeChildren::const_iterator>(newPosition.m_it);
+    if (hint == from)
+    {
+        // The renamed node stays before the successor of its old place
+        ++hint;
+    }
+
+    // The extracted node isn't ordered, so its key can be changed
+    auto handle          = tree.extract(from);
+    handle.value()->name = newName;
+    return tree.insert(hint, std::move(handle))->get();
+}
+
+void FsChildren::reserve(const std::size_t size)
+{
+    if (auto flat = std::get_if<FlatChildren>(&m_children); flat && size < wideDirectoryMinSize)
+    {
+        flat->reserve(size);
+    }
+}
+
+std::size_t FsChildren::size() const noexcept
+{
+    return std::visit(
+      [](const auto& children)
+      {
+          return children.size();
+      },
+      m_children);
+}
+
+void FsChildren::updateRepresentation()
+{
+    if (auto flat = std::get_if<FlatChildren>(&m_children); flat && flat->size() > wideDirectoryMinSize)
+    {
+        auto tree = TreeChildren{};
+        for (auto& child : *flat)
+        {
+            tree.insert(tree.end(), std::move(child));
+        }
+        m_children = std::move(tree);
+    }
+    else if (auto tree = std::get_if<TreeChildren>(&m_children); tree && tree->size() < smallDirectoryMaxSize)
+    {
+        auto flat = FlatChildren{};
+        flat.reserve(tree->size());
+        while (!tree->empty())
+        {
+            flat.push_back(std::move(tree->extract(tree->begin()).value()));
+        }
+        m_children = std::move(flat);
+    }
+}
+
+FsDirectoryRef::FsDirectoryRef(FsDirectory* const directory) noexcept : m_directory{directory}
+{
+}
+
+FsDirectoryRef::FsDirectoryRef(const FsDirectoryRef& other) noexcept : m_directory{other.m_directory}
+{
+    if (m_directory)
+    {
+        ++m_directory->refCount;
+    }
+}
+
+FsDirectoryRef::FsDirectoryRef(FsDirectoryRef&& other) noexcept : m_directory{std::exchange(other.m_directory, nullptr)}
+{
+}
+
+FsDirectoryRef::~FsDirectoryRef()
+{
+    if (m_directory && --m_directory->refCount == 0)
+    {
+        const auto allocator = m_directory->allocator;
+        m_directory->~FsDirectory();
+        allocator->deallocate(m_directory);
+    }
+}
+
+FsDirectoryRef& FsDirectoryRef::operator=(FsDirectoryRef other) noexcept
+{
+    std::swap(m_directory, other.m_directory);
+    return *this;
+}
+
+FsDirectory* FsDirectoryRef::operator->() const noexcept
+{
+    return m_directory;
+}
+
+FsDirectoryRef::operator bool() const noexcept
+{
+    return m_directory != nullptr;
+}
+
+FsDirectory* FsDirectoryRef::get() const noexcept
+{
+    return m_directory;
+}
+
+bool FsDirectoryRef::isShared() const noexcept
+{
+    return m_directory && m_directory->refCount > 1;
+}
+
+FsNode* FsNode::addChild(FsNodeStorage& storage, FsNodePtr child)
+{
+    child->parent       = this;
+    const auto inserted = mutableChildren(storage).insert(std::move(child));
+    if (inserted)
+    {
+        updateAncestorsStats(this, *inserted, true);
+    }
+    return inserted;
+}
+
+FsNode* FsNode::addChild(FsNodeStorage& storage, const FsChildren::const_iterator position, FsNodePtr child)
+{
+    child->parent       = this;
+    const auto inserted = mutableChildren(storage).insert(position, std::move(child));
+    updateAncestorsStats(this, *inserted, true);
+    return inserted;
+}
+
+const FsChildren& FsNode::children() const noexcept
+{
+    return directory ? directory->children : emptyChildren;
+}
+
+FsNodePtr FsNode::copy(FsNodeStorage& storage, const std::string_view newName) const
+{
+    return storage.createNode(newName.empty() ? name : FsName{newName}, isDirectory(), directory);
+}
+
+std::size_t FsNode::depth() const noexcept
+{
+    auto result = std::size_t{0};
+    for (auto node = parent; node; node = node->parent)
+    {
+        ++result;
+    }
+    return result;
+}
+
+FsNodePtr FsNode::extractChild(FsNodeStorage& storage, const std::string_view name)
+{
+    auto child = mutableChildren(storage).extract(name);
+    if (child)
+    {
+        child->parent = nullptr;
+        updateAncestorsStats(this, *child, false);
+    }
+    return child;
+}
+
+FsNodePtr FsNode::extractChild(FsNodeStorage& storage, const FsChildren::const_iterator position)
+{
+    auto child    = mutableChildren(storage).extract(position);
+    child->parent = nullptr;
+    updateAncestorsStats(this, *child, false);
+    return child;
+}
+
+bool FsNode::isDirectory() const noexcept
+{
+    return name.flag(directoryFlag);
+}
+
+bool FsNode::isAncestorOf(const FsNode& node) const noexcept
+{
+    for (auto ancestor = node.parent; ancestor; ancestor = ancestor->parent)
+    {
+        if (ancestor == this)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+FsChildren& FsNode::mutableChildren(FsNodeStorage& storage)
+{
+    if (!directory)
+    {
+        // Files don't have children, but the callers expect a valid container
+        directory = storage.createDirectory();
+    }
+    else if (directory.isShared())
+    {
+        auto clone = storage.createDirectory();
+        clone->children.reserve(directory->children.size());
+
+        for (const auto& child : directory->children)
+        {
+            // The children are visited in ascending order, so every insertion is an append
+            auto childCopy    = child->copy(storage);
+            childCopy->parent = this;
+            clone->children.insert(std::move(childCopy));
+        }
+        // The children of the clone share the contents of the original children, so the subtree is the same
+        clone->stats = directory->stats;
+
+        directory = std::move(clone);
+    }
+    else if (const auto& children = directory->children; !children.empty() && children.begin()->get()->parent != this)
+    {
+        // The content was shared and the other directory has cloned it, so this directory is the only owner now.
+        // All children of a content have the same parent link, so checking of the first child is enough.
+        for (const auto& child : children)
+        {
+            child->parent = this;
+        }
+    }
+
+    return directory->children;
+}
+
+void FsNode::appendPath(std::string& result) const
+{
+    // The root is named as the delimiter, so its name isn't repeated before the names of its children
+    if (!parent)
+    {
+        result.append(name.view());
+        return;
+    }
+
+    auto length = std::size_t{0};
+    for (auto node = this; node->parent; node = node->parent)
+    {
+        length += node->name.size() + 1;
+    }
+
+    // The path is filled from the end, so the names are visited only once after the length is known
+    result.append(length, '/');
+    auto end = result.size();
+    for (auto node = this; node->parent; node = node->parent)
+    {
+        end -= node->name.size();
+        result.replace(end, node->name.size(), node->name.view());
+        --end;
+    }
+}
+
+std::string FsNode::path() const
+{
+    auto result = std::string{};
+    appendPath(result);
+    return result;
+}
+
+const FsSubtreeStats& FsNode::stats() const noexcept
+{
+    return directory ? directory->stats : emptyStats;
+}
+
+void FsSubtreeStats::addChild(const FsNode& child) noexcept
+{
+    const auto& childStats  = child.stats();
+    files                  += childStats.files + (child.isDirectory() ? 0 : 1);
+    directories            += childStats.directories + (child.isDirectory() ? 1 : 0);
+
+    const auto height = childStats.maxDepth + 1;
+    if (height > maxDepth)
+    {
+        maxDepth        = height;
+        deepestChildren = 1;
+    }
+    else if (height == maxDepth)
+    {
+        ++deepestChildren;
+    }
+}
+
+FsNodeStorage::FsNodeStorage() :
+    m_nodeAllocator{sizeof(FsNode), alignof(FsNode)}, m_directoryAllocator{sizeof(FsDirectory), alignof(FsDirectory)}
+{
+}
+
+FsDirectoryRef FsNodeStorage::createDirectory()
+{
+    const auto directory =
+      constructInAllocator<FsDirectory>(m_directoryAllocator, &m_directoryAllocator, std::size_t{1});
+    return FsDirectoryRef{directory};
+}
+
+FsNodePtr FsNodeStorage::createNode(const std::string_view name, const bool isDirectory)
+{
+    return createNode(FsName{name}, isDirectory, isDirectory ? createDirectory() : FsDirectoryRef{});
+}
+
+FsNodePtr FsNodeStorage::createNode(FsName name, const bool isDirectory, FsDirectoryRef directory)
+{
+    name.setFlag(FsNode::directoryFlag, isDirectory);
+    const auto node = constructInAllocator<FsNode>(m_nodeAllocator, std::move(name), std::move(directory), nullptr);
+    return FsNodePtr{node, FsNodeDeleter{.allocator = &m_nodeAllocator}};
+}
+
+const SlabAllocator::Statistics& FsNodeStorage::directoryAllocatorStatistics() const noexcept
+{
+    return m_directoryAllocator.statistics();
+}
+
+const SlabAllocator::Statistics& FsNodeStorage::nodeAllocatorStatistics() const noexcept
+{
+    return m_nodeAllocator.statistics();
+}
@@ -0,0 +1,55 @@
+#include "fs_node_reclaimer.h"
+
+#include <limits>
+#include <utility>
+
+FsNodeReclaimer::~FsNodeReclaimer()
+{
+    reclaimAll();
+}
+
+void FsNodeReclaimer::defer(FsNodePtr node)
+{
+    if (node)
+    {
+        m_pendingNodes.push_back(std::move(node));
+    }
+}
+
+bool FsNodeReclaimer::empty() const noexcept
+{
+    return m_pendingNodes.empty();
+}
+
+std::size_t FsNodeReclaimer::reclaim(const std::size_t maxNodes)
+{
+    auto freedNodes = std::size_t{0};
+
+    for (; freedNodes < maxNodes && !m_pendingNodes.empty(); ++freedNodes)
+    {
+        auto node = std::move(m_pendingNodes.back());
+        m_pendingNodes.pop_back();
+
+        if (node->directory && !node->directory.isShared())
+        {
+            // The children are freed by the next slices, so the node is destroyed with the empty content
+            node->directory->children.extractAll(m_pendingNodes);
+        }
+    }
+
+    return freedNodes;
+}
+
+void FsNodeReclaimer::reclaimAll()
+{
+    reclaim(std::numeric_limits<std::size_t>::max());
+}
+
+void FsNodeReclaimer::release() noexcept
+{
+    for (auto& node : m_pendingNodes)
+    {
+        static_cast<void>(node.release());
+    }
+    m_pendingNodes.clear();
+}
@@ -0,0 +1,344 @@
+#include "fs_snapshot.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr inline char snapshotMagic[8] = {'F', 'M', 'E', 'S', 'N', 'A', 'P', '\0'};
+constexpr inline auto snapshotVersion  = std::uint32_t{1};
+constexpr inline auto maxIndex         = std::numeric_limits<std::uint32_t>::max();
+constexpr inline auto noContent        = maxIndex;  // The content index of the files
+constexpr inline auto directoryFlag    = std::uint32_t{1};
+constexpr inline auto pathDelimiter    = '/';
+
+struct SnapshotHeader
+{
+        char          magic[8];
+        std::uint32_t version;
+        std::uint32_t nodesNumber;
+        std::uint32_t contentsNumber;
+        std::uint32_t stringsSize;
+};
+
+struct SnapshotNode
+{
+        std::uint32_t nameOffset;
+        std::uint32_t nameSize;
+        std::uint32_t content;  // The index of the content of the directory or noContent
+        std::uint32_t flags;
+};
+
+struct SnapshotContent
+{
+        std::uint32_t firstNode;
+        std::uint32_t nodesNumber;
+};
+
+/**
+ * \brief Returns the contents of the tree ordered so that every content precedes the contents of its children.
+ */
+std::vector<const FsDirectory*> orderContents(const FsNode& root)
+{
+    struct Frame
+    {
+        const FsDirectory*         content;
+        FsChildren::const_iterator nextChild;
+    };
+
+    auto order   = std::vector<const FsDirectory*>{};
+    auto visited = std::unordered_set<const FsDirectory*>{};
+    auto stack   = std::vector<Frame>{};
+
+    const auto visit = [&visited, &stack](const FsDirectory* content)
+    {
+        if (visited.insert(content).second)
+        {
+            stack.push_back(Frame{.content = content, .nextChild = content->children.begin()});
+        }
+    };
+
+    // The reversed post-order of the depth-first traversal is the topological order of the shared contents
+    visit(root.directory.get());
+    while (!stack.empty())
+    {
+        auto& frame = stack.back();
+        if (frame.nextChild == frame.content->children.end())
+        {
+            order.push_back(frame.content);
+            stack.pop_back();
+            continue;
+        }
+
+        const auto& child = *frame.nextChild++;
+        if (child->isDirectory() && child->directory)
+        {
+            visit(child->directory.get());
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+template<typename T>
+T readRecord(const char* const records, const std::size_t index)
+{
+    // The mapped data has no alignment guarantees for the records, so they are copied
+    auto record = T{};
+    std::memcpy(&record, records + index * sizeof(T), sizeof(T));
+    return record;
+}
+
+template<typename T>
+void writeRecords(std::ostream& output, const std::vector<T>& records)
+{
+    output.write(reinterpret_cast<const char*>(records.data()),
+                 static_cast<std::streamsize>(records.size() * sizeof(T)));
+}
+
+}  // namespace
+
+std::string_view snapshotErrorToString(const SnapshotError error)
+{
+    switch (error)
+    {
+        case SnapshotError::CannotOpenFile:
+            return "Cannot open the snapshot file";
+        case SnapshotError::CannotWriteFile:
+            return "Cannot write the snapshot file";
+        case SnapshotError::InvalidFormat:
+            return "The snapshot is corrupted or has the unsupported format";
+        case SnapshotError::TooLarge:
+            return "The tree is too large for the snapshot";
+        default:
+            return "";
+    }
+}
+
+SnapshotError saveSnapshot(const FsNode& root, std::ostream& output)
+{
+    if (!root.directory)
+    {
+        return SnapshotError::InvalidFormat;
+    }
+
+    const auto contents = orderContents(root);
+    auto       indexes  = std::unordered_map<const FsDirectory*, std::uint32_t>{};
+    indexes.reserve(contents.size());
+    for (auto i = std::size_t{0}; i < contents.size(); ++i)
+    {
+        indexes.emplace(contents[i], static_cast<std::uint32_t>(i));
+    }
+
+    auto nodes         = std::vector<SnapshotNode>{};
+    auto contentsTable = std::vector<SnapshotContent>{};
+    auto strings       = std::string{};
+    auto nameOffsets   = std::unordered_map<std::string_view, std::uint32_t>{};  // The names are stored once
+
+    const auto makeNode = [&indexes, &strings, &nameOffsets](const FsNode& node)
+    {
+        const auto [it, inserted] = nameOffsets.try_emplace(node.name, static_cast<std::uint32_t>(strings.size()));
+        if (inserted)
+        {
+            strings.append(node.name);
+        }
+
+        const auto isDirectory = node.isDirectory() && node.directory;
+        return SnapshotNode{.nameOffset = it->second,
+                            .nameSize   = static_cast<std::uint32_t>(node.name.size()),
+                            .content    = isDirectory ? indexes.at(node.directory.get()) : noContent,
+                            .flags      = node.isDirectory() ? directoryFlag : 0};
+    };
+
+    nodes.push_back(makeNode(root));
+    contentsTable.reserve(contents.size());
+    for (const auto content : contents)
+    {
+        contentsTable.push_back(SnapshotContent{.firstNode   = static_cast<std::uint32_t>(nodes.size()),
+                                                .nodesNumber = static_cast<std::uint32_t>(content->children.size())});
+        for (const auto& child : content->children)
+        {
+            nodes.push_back(makeNode(*child));
+        }
+    }
+
+    // The offsets and the indexes are truncated above only if the totals don't fit, so the totals are checked
+    if (nodes.size() >= maxIndex || contents.size() >= maxIndex || strings.size() >= maxIndex)
+    {
+        return SnapshotError::TooLarge;
+    }
+
+    auto header = SnapshotHeader{};
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version        = snapshotVersion;
+    header.nodesNumber    = static_cast<std::uint32_t>(nodes.size());
+    header.contentsNumber = static_cast<std::uint32_t>(contentsTable.size());
+    header.stringsSize    = static_cast<std::uint32_t>(strings.size());
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeRecords(output, nodes);
+    writeRecords(output, contentsTable);
+    output.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+    output.flush();
+
+    return output ? SnapshotError::NoError : SnapshotError::CannotWriteFile;
+}
+
+SnapshotError loadSnapshot(const std::string_view data, FsNodeStorage& storage, FsNodePtr& root)
+{
+    if (data.size() < sizeof(SnapshotHeader))
+    {
+        return SnapshotError::InvalidFormat;
+    }
+
+    const auto header = readRecord<SnapshotHeader>(data.data(), 0);
+    if (std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0 || header.version != snapshotVersion
+        || header.nodesNumber == 0 || header.contentsNumber == 0
+        || data.size() - sizeof(SnapshotHeader) != std::size_t{header.nodesNumber} * sizeof(SnapshotNode)
+                                                     + std::size_t{header.contentsNumber} * sizeof(SnapshotContent)
+                                                     + header.stringsSize)
+    {
+        return SnapshotError::InvalidFormat;
+    }
+
+    const auto nodes    = data.data() + sizeof(SnapshotHeader);
+    const auto contents = nodes + std::size_t{header.nodesNumber} * sizeof(SnapshotNode);
+    const auto strings  = data.substr(data.size() - header.stringsSize);
+
+    const auto nameOf = [strings](const SnapshotNode& node)
+    {
+        return std::size_t{node.nameOffset} + node.nameSize <= strings.size()
+               ? strings.substr(node.nameOffset, node.nameSize)
+               : std::string_view{};
+    };
+
+    const auto rootRecord = readRecord<SnapshotNode>(nodes, 0);
+    if (nameOf(rootRecord) != std::string_view{&pathDelimiter, 1} || rootRecord.flags != directoryFlag
+        || rootRecord.content != 0)
+    {
+        return SnapshotError::InvalidFormat;
+    }
+
+    // A content is created on the first reference and filled once, the next references share it
+    auto contentRefs = std::vector<FsDirectoryRef>(header.contentsNumber);
+    auto filled      = std::vector<bool>(header.contentsNumber, false);
+    auto pending     = std::vector<std::pair<FsNode*, std::uint32_t>>{};  // The contents to fill with their owners
+
+    const auto contentRef = [&storage, &contentRefs](const std::uint32_t index)
+    {
+        if (!contentRefs[index])
+        {
+            contentRefs[index] = storage.createDirectory();
+        }
+        return contentRefs[index];
+    };
+
+    // Every name is stored once in the snapshot, so the nodes with the same long name share it after loading too
+    auto       longNames    = std::unordered_map<std::uint32_t, FsName>{};
+    const auto internedName = [&longNames](const std::uint32_t nameOffset, const std::string_view name)
+    {
+        return name.size() <= FsName::maxInlineSize ? FsName{name}
+                                                    : longNames.try_emplace(nameOffset, name).first->second;
+    };
+
+    const auto buildTree = [&]() -> FsNodePtr
+    {
+        auto newRoot = storage.createNode(FsName{nameOf(rootRecord)}, true, contentRef(0));
+        pending.emplace_back(newRoot.get(), 0);
+
+        while (!pending.empty())
+        {
+            const auto [owner, index] = pending.back();
+            pending.pop_back();
+            if (filled[index])
+            {
+                continue;
+            }
+            filled[index] = true;
+
+            const auto content = readRecord<SnapshotContent>(contents, index);
+            if (std::size_t{content.firstNode} + content.nodesNumber > header.nodesNumber)
+            {
+                return nullptr;
+            }
+
+            auto& children = contentRefs[index]->children;
+            children.reserve(content.nodesNumber);
+
+            for (auto i = content.firstNode; i < content.firstNode + content.nodesNumber; ++i)
+            {
+                const auto record      = readRecord<SnapshotNode>(nodes, i);
+                const auto name        = nameOf(record);
+                const auto isDirectory = record.flags == directoryFlag;
+
+                // The contents refer only to the contents with greater indexes, so the tree cannot have cycles
+                if (name.empty() || name.find(pathDelimiter) != std::string_view::npos || record.flags > directoryFlag
+                    || (record.content != noContent && (!isDirectory || record.content <= index
+                                                        || record.content >= header.contentsNumber)))
+                {
+                    return nullptr;
+                }
+
+                auto directory = record.content != noContent
+                                 ? contentRef(record.content)
+                                 : (isDirectory ? storage.createDirectory() : FsDirectoryRef{});
+                auto child     = storage.createNode(internedName(record.nameOffset, name), isDirectory,
+                                                    std::move(directory));
+                child->parent  = owner;
+
+                const auto insertedChild = children.insert(std::move(child));
+                if (!insertedChild)
+                {
+                    return nullptr;  // Duplicated name
+                }
+                if (record.content != noContent)
+                {
+                    pending.emplace_back(insertedChild, record.content);
+                }
+            }
+        }
+
+        return newRoot;
+    };
+
+    auto newRoot = buildTree();
+    if (newRoot)
+    {
+        // The contents refer only to the contents with greater indexes, so the aggregates of the children of
+        // a content are ready before it
+        for (auto index = contentRefs.size(); index-- > 0;)
+        {
+            if (const auto content = contentRefs[index].get())
+            {
+                for (const auto& child : content->children)
+                {
+                    content->stats.addChild(*child);
+                }
+            }
+        }
+    }
+
+    // The references are dropped in the topological order, so freeing of a content never recurses
+    // into the contents of its children
+    for (auto& ref : contentRefs)
+    {
+        ref = FsDirectoryRef{};
+    }
+
+    if (!newRoot)
+    {
+        return SnapshotError::InvalidFormat;
+    }
+
+    root = std::move(newRoot);
+    return SnapshotError::NoError;
+}
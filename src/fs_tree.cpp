@@ -0,0 +1,1157 @@
+#include "fs_tree.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+
+#include "byte_scanner.h"
+#include "fme_metrics.h"
+#include "helpers.h"
+
+namespace
+{
+constexpr inline auto pathDelimiter = '/';
+
+constexpr inline auto defaultPathCacheCapacity = std::size_t{1024};
+
+// The pattern component, which matches any number of the directories
+constexpr inline auto globstar = std::string_view{"**"};
+
+// The pattern component, which matches any item of the directory
+constexpr inline auto anyItem = std::string_view{"*"};
+
+FsResult makeError(const FsError error, const std::string_view path, const std::string_view component = {},
+                   const std::string_view directory = {})
+{
+    return FsResult{.error = error, .path = path, .directory = directory, .component = component};
+}
+
+// The basename of the normalized path with the trailing '/'
+std::string_view basenameWithSlash(const std::string_view normalizedPath, const std::string_view basename)
+{
+    return normalizedPath.substr(normalizedPath.size() - basename.size() - 1);
+}
+
+// The name of the item of the normalized path without the trailing '/'
+std::string_view itemName(const std::string_view normalizedPath)
+{
+    return normalizedPath.substr(normalizedPath.find_last_of(pathDelimiter) + 1);
+}
+
+// The parent path of the normalized path without the trailing '/'
+std::string_view parentPath(const std::string_view normalizedPath)
+{
+    const auto delimiterPos = normalizedPath.find_last_of(pathDelimiter);
+    return delimiterPos == 0 ? normalizedPath.substr(0, 1) : normalizedPath.substr(0, delimiterPos);
+}
+
+// Checks that the path is the ancestor path or is inside it
+bool isSameOrInside(const std::string_view path, const std::string_view ancestorPath)
+{
+    return path.starts_with(ancestorPath)
+        && (path.size() == ancestorPath.size() || ancestorPath.size() == 1
+            || path[ancestorPath.size()] == pathDelimiter);
+}
+
+// Orders the paths as the tree walk: '/' precedes all characters, so a subtree follows its root
+bool pathLess(const std::string_view a, const std::string_view b)
+{
+    const auto rank = [](const char c)
+    {
+        return c == pathDelimiter ? 0 : static_cast<unsigned char>(c) + 1;
+    };
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+                                        [rank](const char x, const char y) { return rank(x) < rank(y); });
+}
+
+// Appends the path of the parent and the name of the item to the strings of the undo log, returns their sizes
+std::array<std::uint32_t, 2> appendUndoPath(std::string& paths, const FsNode& parent, const std::string_view name)
+{
+    const auto start = paths.size();
+    parent.appendPath(paths);
+    paths.append(name);
+    return {static_cast<std::uint32_t>(paths.size() - start - name.size()), static_cast<std::uint32_t>(name.size())};
+}
+
+}  // namespace
+
+FsTree::FsTree() :
+    m_nodeStorage{std::make_unique<FsNodeStorage>()},
+    m_root{m_nodeStorage->createNode(std::string{pathDelimiter}, true)},
+    m_pathCache{defaultPathCacheCapacity}
+{
+}
+
+FsTree::~FsTree()
+{
+    if (m_fastExit)
+    {
+        // The tree is left for the process exit, only the slabs of the storage are returned
+        static_cast<void>(m_root.release());
+        static_cast<void>(m_baseline.release());
+        for (auto& record : m_undoLog)
+        {
+            static_cast<void>(record.node.release());
+        }
+        m_reclaimer.release();
+    }
+    else
+    {
+        // The tree is freed without recursion, so deep trees don't exhaust the stack
+        m_reclaimer.defer(std::move(m_root));
+        m_reclaimer.defer(std::move(m_baseline));
+        dropUndoLog();
+        m_reclaimer.reclaimAll();
+    }
+}
+
+const FsNode* FsTree::baseline() const noexcept
+{
+    return m_baseline.get();
+}
+
+void FsTree::beginTransaction()
+{
+    m_transactions.push_back(m_undoLog.size());
+}
+
+std::size_t FsTree::commitTransaction()
+{
+    const auto changes = m_undoLog.size() - m_transactions.back();
+    m_transactions.pop_back();
+    if (m_transactions.empty())
+    {
+        dropUndoLog();
+    }
+    return changes;
+}
+
+const SlabAllocator::Statistics& FsTree::directoryAllocatorStatistics() const
+{
+    return m_nodeStorage->directoryAllocatorStatistics();
+}
+
+void FsTree::dropBaseline()
+{
+    m_reclaimer.defer(std::move(m_baseline));
+}
+
+void FsTree::keepBaseline()
+{
+    dropBaseline();
+    m_baseline = m_root->copy(*m_nodeStorage);
+    // The cached nodes are shared with the baseline now, so they must be unshared before modification
+    m_pathCache.invalidate();
+}
+
+SnapshotError FsTree::loadSnapshot(const std::string_view data)
+{
+    auto       root  = FsNodePtr{};
+    const auto error = ::loadSnapshot(data, *m_nodeStorage, root);
+    if (error == SnapshotError::NoError)
+    {
+        replaceRoot(std::move(root));
+    }
+    return error;
+}
+
+const FsTree::LookupStatistics& FsTree::lookupStatistics() const noexcept
+{
+    return m_lookupStatistics;
+}
+
+FsTree::MemoryUsage FsTree::memoryUsage() const
+{
+    // A shared content is visited once, so its children are counted once too
+    auto usage    = MemoryUsage{};
+    auto contents = std::unordered_set<const FsDirectory*>{};
+    auto names    = std::unordered_set<const void*>{};
+    auto pending  = std::vector<const FsNode*>{m_root.get()};
+
+    while (!pending.empty())
+    {
+        const auto node = pending.back();
+        pending.pop_back();
+
+        ++usage.nodes;
+        if (const auto name = node->name.heapData(); name && names.insert(name).second)
+        {
+            ++usage.longNames;
+            usage.nameBytes += node->name.heapSize();
+        }
+        if (const auto directory = node->directory.get(); directory && contents.insert(directory).second)
+        {
+            ++usage.directories;
+            usage.childrenBytes += directory->children.heapSize();
+            for (const auto& child : directory->children)
+            {
+                pending.push_back(child.get());
+            }
+        }
+    }
+
+    usage.nodeBytes      = usage.nodes * sizeof(FsNode);
+    usage.directoryBytes = usage.directories * sizeof(FsDirectory);
+    return usage;
+}
+
+const SlabAllocator::Statistics& FsTree::nodeAllocatorStatistics() const
+{
+    return m_nodeStorage->nodeAllocatorStatistics();
+}
+
+const PathCache::Statistics& FsTree::pathCacheStatistics() const
+{
+    return m_pathCache.statistics();
+}
+
+std::size_t FsTree::reclaim(const std::size_t maxNodes)
+{
+    return m_reclaimer.reclaim(maxNodes);
+}
+
+void FsTree::replaceRoot(FsNodePtr root)
+{
+    // The old tree is freed in slices, the undo log refers to it
+    m_pathCache.invalidate();
+    m_reclaimer.defer(std::exchange(m_root, std::move(root)));
+    m_transactions.clear();
+    dropUndoLog();
+}
+
+std::size_t FsTree::rollbackTransaction()
+{
+    const auto start = m_transactions.back();
+    m_transactions.pop_back();
+
+    // Every record is undone on the tree, which is restored up to the state right after its change,
+    // so its paths are valid. The nodes are found again, since the undone changes invalidate the cache.
+    const auto changes = m_undoLog.size() - start;
+    auto       result  = FsResult{};
+    while (m_undoLog.size() > start)
+    {
+        auto&      record    = m_undoLog.back();
+        const auto pathsSize = std::size_t{record.sizes[0]} + record.sizes[1] + record.sizes[2] + record.sizes[3];
+        const auto paths     = std::string_view{m_undoPaths}.substr(m_undoPaths.size() - pathsSize);
+        const auto path      = paths.substr(0, record.sizes[0]);
+        const auto name      = paths.substr(record.sizes[0], record.sizes[1]);
+        const auto parent    = findNodeByPath(path, result);
+
+        switch (record.action)
+        {
+            case UndoAction::Remove:
+                m_reclaimer.defer(parent->extractChild(*m_nodeStorage, name));
+                m_pathCache.invalidate();
+                break;
+            case UndoAction::Insert:
+                parent->addChild(*m_nodeStorage, std::move(record.node));
+                break;
+            case UndoAction::Move:
+            {
+                auto node = parent->extractChild(*m_nodeStorage, name);
+                m_pathCache.invalidate();
+
+                const auto originalPath = paths.substr(record.sizes[0] + record.sizes[1], record.sizes[2]);
+                const auto originalName = paths.substr(record.sizes[0] + record.sizes[1] + record.sizes[2]);
+                if (node->name != originalName)
+                {
+                    node->name = originalName;
+                }
+                findNodeByPath(originalPath, result)->addChild(*m_nodeStorage, std::move(node));
+                break;
+            }
+        }
+
+        m_undoPaths.resize(m_undoPaths.size() - pathsSize);
+        m_undoLog.pop_back();
+    }
+    return changes;
+}
+
+const FsNode& FsTree::root() const noexcept
+{
+    return *m_root;
+}
+
+SnapshotError FsTree::saveSnapshot(std::ostream& output) const
+{
+    return ::saveSnapshot(*m_root, output);
+}
+
+void FsTree::setCountLookups(const bool countLookups) noexcept
+{
+    m_countLookups = metricsEnabled && countLookups;
+}
+
+void FsTree::setFastExit(const bool fastExit) noexcept
+{
+    m_fastExit = fastExit;
+}
+
+void FsTree::setPathCacheCapacity(const std::size_t capacity)
+{
+    m_pathCache.resize(capacity);
+}
+
+FsNodeStorage& FsTree::storage() noexcept
+{
+    return *m_nodeStorage;
+}
+
+std::size_t FsTree::transactionDepth() const noexcept
+{
+    return m_transactions.size();
+}
+
+FsResult FsTree::cp(const std::string_view source, const std::string_view destination)
+{
+    return validateAndTransferNode(source, destination, NodeTransferMode::Copy);
+}
+
+FsResult FsTree::cpMatching(const std::string_view pattern, const std::string_view destination)
+{
+    return transferMatching(pattern, destination, NodeTransferMode::Copy);
+}
+
+FsResult FsTree::du(const std::string_view path)
+{
+    const auto nodePathInfo   = parsePath(path, m_sourcePathBuffer);
+    const auto normalizedPath = nodePathInfo.normalizedPath;
+    if (isRootDirectory(nodePathInfo.path, nodePathInfo.basename))
+    {
+        return FsResult{.isDirectory = true, .path = normalizedPath, .stats = m_root->stats()};
+    }
+
+    // The node is only read, so its shared content isn't cloned
+    auto       result = FsResult{};
+    const auto parent = findNodeByPath(nodePathInfo.path, result, NodeAccess::ReadOnly);
+    if (!parent)
+    {
+        return result;
+    }
+
+    countChildrenLookup(false);
+    const auto node = parent->children().find(nodePathInfo.basename);
+    if (!node)
+    {
+        return makeError(FsError::NoSuchItem, normalizedPath);
+    }
+    if (!node->isDirectory() && normalizedPath.back() == pathDelimiter)
+    {
+        return makeError(FsError::InvalidFileReference, normalizedPath,
+                         basenameWithSlash(normalizedPath, nodePathInfo.basename));
+    }
+    return FsResult{.isDirectory = node->isDirectory(), .path = normalizedPath, .stats = node->stats()};
+}
+
+FsResult FsTree::md(const std::string_view dirAbsolutePath)
+{
+    return validateAndCreateNode(NodeType::Directory, dirAbsolutePath, false);
+}
+
+FsResult FsTree::mf(const std::string_view fileAbsolutePath)
+{
+    return validateAndCreateNode(NodeType::File, fileAbsolutePath, true);
+}
+
+FsResult FsTree::mv(const std::string_view source, const std::string_view destination)
+{
+    return validateAndTransferNode(source, destination, NodeTransferMode::Move);
+}
+
+FsResult FsTree::mvMatching(const std::string_view pattern, const std::string_view destination)
+{
+    return transferMatching(pattern, destination, NodeTransferMode::Move);
+}
+
+FsResult FsTree::rm(const std::string_view absolutePath)
+{
+    const auto nodePathInfo   = parsePath(absolutePath, m_sourcePathBuffer);
+    const auto normalizedPath = nodePathInfo.normalizedPath;
+    auto       result         = FsResult{};
+    const auto parent         = findNodeByPath(nodePathInfo.path, result);
+
+    if (!parent)
+    {
+        return result;
+    }
+
+    countChildrenLookup(false);
+    if (!parent->children().contains(nodePathInfo.basename))
+    {
+        return makeError(FsError::NoSuchItem, normalizedPath);
+    }
+
+    // The subtree is only detached here, it is freed in slices by reclaim() or kept for the rollback.
+    // The cache can refer to the removed subtree.
+    keepRemoved(*parent, parent->extractChild(*m_nodeStorage, nodePathInfo.basename));
+    m_pathCache.invalidate();
+    return FsResult{.path = normalizedPath};
+}
+
+FsResult FsTree::rmMatching(const std::string_view pattern)
+{
+    const auto normalizedPattern = parsePath(pattern, m_sourcePathBuffer).normalizedPath;
+    collectMatches(normalizedPattern);
+    if (m_matches.empty())
+    {
+        return makeError(FsError::NoMatches, normalizedPattern);
+    }
+
+    // The parent is found once for the adjacent matches of one directory
+    auto result     = FsResult{.path = normalizedPattern, .matchesNumber = m_matches.size()};
+    auto parent     = static_cast<FsNode*>(nullptr);
+    auto lastParent = std::string_view{};
+    for (const auto& match : m_matches)
+    {
+        const auto matchParent = parentPath(match.path);
+        if (!parent || matchParent != lastParent)
+        {
+            parent     = findNodeByPath(matchParent, result);
+            lastParent = matchParent;
+            if (!parent)
+            {
+                return result;
+            }
+        }
+        keepRemoved(*parent, parent->extractChild(*m_nodeStorage, itemName(match.path)));
+    }
+
+    // The cache can refer to the removed subtrees
+    m_pathCache.invalidate();
+    return result;
+}
+
+void FsTree::collectMatches(const std::string_view normalizedPattern)
+{
+    // The walk is iterative: every frame of the stack is a position in the children of one directory, which are
+    // matched with the wildcard component or are consumed by "**". The literal components are looked up directly.
+    struct Frame
+    {
+            std::size_t                component;
+            FsChildren::const_iterator nextChild;
+            FsChildren::const_iterator end;
+            std::size_t                pathLength;
+    };
+
+    auto components = std::vector<std::string_view>{};
+    for (auto startPos = std::size_t{1}; startPos < normalizedPattern.size();)
+    {
+        const auto delimiterPos = std::min(normalizedPattern.find(pathDelimiter, startPos), normalizedPattern.size());
+        const auto component    = normalizedPattern.substr(startPos, delimiterPos - startPos);
+        if (component != globstar || components.empty() || components.back() != globstar)
+        {
+            components.push_back(component);
+        }
+        startPos = delimiterPos + 1;
+    }
+    if (!components.empty() && components.back() == globstar)
+    {
+        // The items inside the matches are dropped, so "**" in the end matches as "*" with no directories before
+        components.back() = anyItem;
+    }
+    const auto directoriesOnly = normalizedPattern.size() > 1 && normalizedPattern.back() == pathDelimiter;
+
+    auto path  = std::string{};
+    auto stack = std::vector<Frame>{};
+    m_matches.clear();
+
+    // Matches the components starting from the node, the path is the path of the node
+    const auto enter = [&](FsNode* node, std::size_t component)
+    {
+        for (;;)
+        {
+            if (component == components.size())
+            {
+                if (!path.empty() && (!directoriesOnly || node->isDirectory()))
+                {
+                    m_matches.push_back(GlobMatch{.path = path, .node = node});
+                }
+                return;
+            }
+            if (!node->isDirectory())
+            {
+                return;
+            }
+
+            const auto name = components[component];
+            if (name == globstar || isGlobPattern(name))
+            {
+                const auto& children = node->children();
+                stack.push_back(Frame{.component  = component,
+                                      .nextChild  = children.begin(),
+                                      .end        = children.end(),
+                                      .pathLength = path.size()});
+                if (name != globstar)
+                {
+                    return;
+                }
+                // "**" also matches no directories, so the rest of the pattern is matched from the same node
+                ++component;
+                continue;
+            }
+
+            const auto child = node->children().find(name);
+            countChildrenLookup(true);
+            if (!child)
+            {
+                return;
+            }
+            path.push_back(pathDelimiter);
+            path.append(name);
+            node = child;
+            ++component;
+        }
+    };
+
+    enter(m_root.get(), 0);
+    while (!stack.empty())
+    {
+        auto& frame = stack.back();
+        if (frame.nextChild == frame.end)
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        const auto child      = (frame.nextChild++)->get();
+        const auto component  = frame.component;
+        const auto isGlobstar = components[component] == globstar;
+        if (isGlobstar ? !child->isDirectory() : !matchesGlob(components[component], child->name))
+        {
+            continue;
+        }
+        path.resize(frame.pathLength);
+        path.push_back(pathDelimiter);
+        path.append(child->name);
+        // The frame can be moved by the push, so only the copied fields are used
+        enter(child, isGlobstar ? component : component + 1);
+    }
+
+    // Several "**" can match the same item in the different ways
+    std::sort(m_matches.begin(), m_matches.end(),
+              [](const GlobMatch& a, const GlobMatch& b) { return pathLess(a.path, b.path); });
+    m_matches.erase(std::unique(m_matches.begin(), m_matches.end(),
+                                [](const GlobMatch& ancestor, const GlobMatch& match)
+                                { return isSameOrInside(match.path, ancestor.path); }),
+                    m_matches.end());
+}
+
+void FsTree::countChildrenLookup(const bool isPathComponent) noexcept
+{
+    if constexpr (metricsEnabled)
+    {
+        if (m_countLookups)
+        {
+            ++m_lookupStatistics.childrenLookups;
+            m_lookupStatistics.pathComponentsResolved += isPathComponent ? 1 : 0;
+        }
+    }
+}
+
+void FsTree::dropUndoLog()
+{
+    for (auto& record : m_undoLog)
+    {
+        m_reclaimer.defer(std::move(record.node));
+    }
+    m_undoLog.clear();
+    m_undoPaths.clear();
+}
+
+FsNode* FsTree::findNodeByPath(const std::string_view normalizedNodePath, FsResult& result, const NodeAccess access)
+{
+    const auto findNextDelimiter = [normalizedNodePath](const std::size_t startPos)
+    {
+        return findByteOf(normalizedNodePath, ByteClass::Slash, startPos);
+    };
+
+    if (normalizedNodePath == m_root->name)
+    {
+        return m_root.get();
+    }
+    if (const auto cachedNode = m_pathCache.find(normalizedNodePath))
+    {
+        // Cached nodes are always found for modification, so they are suitable for any access
+        return cachedNode;
+    }
+
+    auto startPos = std::size_t{0}, delimiterPos = findNextDelimiter(0);
+    auto currentNode = m_root.get();
+    auto nodeName    = std::string_view{};
+
+    if (delimiterPos == normalizedNodePath.size())
+    {
+        nodeName = normalizedNodePath;
+    }
+    else
+    {
+        for (; delimiterPos < normalizedNodePath.size(); delimiterPos = findNextDelimiter(startPos))
+        {
+            nodeName = normalizedNodePath.substr(startPos, delimiterPos - startPos);
+
+            if (!nodeName.empty())
+            {
+                currentNode = getChildNode(currentNode, nodeName, normalizedNodePath, access, result);
+
+                if (!currentNode)
+                {
+                    return nullptr;
+                }
+            }
+
+            startPos = delimiterPos + 1;
+        }
+
+        nodeName = normalizedNodePath.substr(startPos, normalizedNodePath.length() - startPos);
+
+        if (nodeName.empty() && !currentNode->isDirectory())
+        {
+            // File path with trailing slash is an invalid file reference.
+            result = makeError(FsError::InvalidFileReference, normalizedNodePath, currentNode->name);
+            return nullptr;
+        }
+    }
+
+    if (!nodeName.empty())
+    {
+        currentNode = getChildNode(currentNode, nodeName, normalizedNodePath, access, result);
+    }
+    if (currentNode && access == NodeAccess::Modify)
+    {
+        // The nodes found for reading can be shared, so they must not be modified via the cache
+        m_pathCache.insert(normalizedNodePath, currentNode);
+    }
+    return currentNode;
+}
+
+FsNode* FsTree::findNodeByPath(const std::string_view normalizedNodePath, FsNode* const base,
+                               const std::string_view basePath, FsResult& result)
+{
+    if (normalizedNodePath == basePath)
+    {
+        return base;
+    }
+    if (const auto cachedNode = m_pathCache.find(normalizedNodePath))
+    {
+        return cachedNode;
+    }
+
+    // The root path has no components, so it is compared as the empty string
+    const auto root         = std::string_view{m_root->name};
+    const auto fromPath     = basePath == root ? std::string_view{} : basePath;
+    const auto toPath       = normalizedNodePath == root ? std::string_view{} : normalizedNodePath;
+    const auto isBoundary   = [](const std::string_view path, const std::size_t pos)
+    {
+        return pos == path.size() || path[pos] == pathDelimiter;
+    };
+    const auto mismatchPos  = static_cast<std::size_t>(
+      std::mismatch(fromPath.begin(), fromPath.end(), toPath.begin(), toPath.end()).first - fromPath.begin());
+    // The end of the common ancestor path: the compared parts are equal only up to the last whole component
+    const auto commonLength = isBoundary(fromPath, mismatchPos) && isBoundary(toPath, mismatchPos)
+                              ? mismatchPos
+                              : fromPath.substr(0, mismatchPos).find_last_of(pathDelimiter);
+
+    auto currentNode = base;
+    const auto levelsUp    = std::count(fromPath.begin() + commonLength, fromPath.end(), pathDelimiter);
+    for (auto level = std::ptrdiff_t{0}; level < levelsUp; ++level)
+    {
+        currentNode = currentNode->parent;
+    }
+
+    // The rest of the path consists of non-empty components: "/name1/name2"
+    for (auto startPos = commonLength + 1; startPos <= toPath.size();)
+    {
+        const auto delimiterPos = std::min(toPath.find(pathDelimiter, startPos), toPath.size());
+        currentNode = getChildNode(currentNode, toPath.substr(startPos, delimiterPos - startPos), normalizedNodePath,
+                                   NodeAccess::Modify, result);
+        if (!currentNode)
+        {
+            return nullptr;
+        }
+        startPos = delimiterPos + 1;
+    }
+
+    if (currentNode != m_root.get())
+    {
+        m_pathCache.insert(normalizedNodePath, currentNode);
+    }
+    return currentNode;
+}
+
+FsNode* FsTree::getChildNode(FsNode* const node, const std::string_view childName,
+                             const std::string_view normalizedNodePath, const NodeAccess access, FsResult& result)
+{
+    if (!node->isDirectory())
+    {
+        result = makeError(FsError::NotADirectory, normalizedNodePath, node->name);
+        return nullptr;
+    }
+
+    // The child is going to be modified, so it must not be shared with other nodes.
+    // This also updates the parent links of the children.
+    const auto& children = access == NodeAccess::Modify ? node->mutableChildren(*m_nodeStorage) : node->children();
+    const auto  child    = children.find(childName);
+    countChildrenLookup(true);
+    if (!child)
+    {
+        result = makeError(FsError::PathNotFound, normalizedNodePath, childName, node->name);
+        return nullptr;
+    }
+    return child;
+}
+
+bool FsTree::isRootDirectory(const std::string_view path, const std::string_view basename) const
+{
+    return path == m_root->name && basename.empty();
+}
+
+void FsTree::keepRemoved(const FsNode& parent, FsNodePtr subtree)
+{
+    if (m_transactions.empty())
+    {
+        m_reclaimer.defer(std::move(subtree));
+        return;
+    }
+
+    const auto [pathSize, nameSize] = appendUndoPath(m_undoPaths, parent, {});
+    m_undoLog.push_back(
+      UndoRecord{.action = UndoAction::Insert, .sizes = {pathSize, nameSize}, .node = std::move(subtree)});
+}
+
+FsTree::PathInfo FsTree::parsePath(const std::string_view path, std::string& buffer,
+                                   const NodeType requiredNodeType) const
+{
+    // "//", "/   /" etc. inside of the path are considered as the current node.
+    // "dir1//dir2" and "dir1/   /dir2" are valid path and result is "/dir1/dir2".
+    // The trailing '/' of the entered path is kept. The empty path is considered as the root.
+
+    buffer.clear();
+    buffer.reserve(path.size() + 1);
+
+    auto basenamePos = std::size_t{0};  // The position of the delimiter before the last non-empty component
+    auto startPos    = std::size_t{0};
+    auto hasBasename = false;
+
+    for (;;)
+    {
+        const auto delimiterPos = findByteOf(path, ByteClass::Slash, startPos);
+        const auto nodeName     = trimmed(path.substr(startPos, delimiterPos - startPos));
+        if (!nodeName.empty())
+        {
+            basenamePos = buffer.size();
+            hasBasename = true;
+            buffer.push_back(pathDelimiter);
+            buffer.append(nodeName);
+        }
+        if (delimiterPos == path.size())
+        {
+            if (nodeName.empty())
+            {
+                buffer.push_back(pathDelimiter);
+            }
+            break;
+        }
+        startPos = delimiterPos + 1;
+    }
+
+    const auto normalizedPath       = std::string_view{buffer};
+    const auto pathHasTrailingSlash = normalizedPath.back() == pathDelimiter;
+    // The basename of the root is empty, so only the trailing '/' can be reported as the basename
+    const auto basename = normalizedPath.substr(hasBasename ? basenamePos + 1 : normalizedPath.size() - 1);
+
+    auto result           = PathInfo{};
+    result.normalizedPath = normalizedPath;
+    result.path           = basenamePos == 0 ? std::string_view{m_root->name} : normalizedPath.substr(0, basenamePos);
+
+    if (pathHasTrailingSlash && requiredNodeType == NodeType::File)
+    {
+        // For example, /d1/f1.t/ is Invalid, if f1 is a file
+        //              /d1/f1/ is Invalid too, if f1 is a file
+        // The basename is reported together with the trailing '/'
+        result.basename = basename;
+        result.type     = NodeType::Invalid;
+    }
+    else
+    {
+        result.basename = pathHasTrailingSlash ? basename.substr(0, basename.size() - 1) : basename;
+        // This is a "rough" guess about the file type based on the presence of '.',
+        // since dirs can also have '.' in their names.
+        result.type     = isFilename(result.basename) ? NodeType::File : NodeType::Directory;
+    }
+
+    return result;
+}
+
+void FsTree::recordCreated(const FsNode& parent, const std::string_view name)
+{
+    if (!m_transactions.empty())
+    {
+        const auto [pathSize, nameSize] = appendUndoPath(m_undoPaths, parent, name);
+        m_undoLog.push_back(UndoRecord{.action = UndoAction::Remove, .sizes = {pathSize, nameSize}});
+    }
+}
+
+void FsTree::recordMoved(const FsNode& parent, const std::string_view name, const FsNode& originalParent,
+                         const std::string_view originalName)
+{
+    if (!m_transactions.empty())
+    {
+        const auto [pathSize, nameSize]                 = appendUndoPath(m_undoPaths, parent, name);
+        const auto [originalPathSize, originalNameSize] = appendUndoPath(m_undoPaths, originalParent, originalName);
+        m_undoLog.push_back(UndoRecord{.action = UndoAction::Move,
+                                       .sizes  = {pathSize, nameSize, originalPathSize, originalNameSize}});
+    }
+}
+
+FsResult FsTree::transferNode(const bool isDirectory, FsNode* const parentS,
+                              const FsChildren::const_iterator positionS, FsNode* const parentD,
+                              FsChildren::const_iterator positionD, const std::string_view source,
+                              const std::string_view destination, const std::string_view basenameS,
+                              const std::string_view basenameD, const std::string_view pathD,
+                              const bool ignoreIfAlreadyExist, const NodeTransferMode transferMode)
+{
+    // If destination is "/" (no basename), we must move in the root with the current name.
+    const auto nameAfterTransfer = basenameD.empty() ? basenameS : basenameD;
+    const auto destinationPath   = basenameD.empty() ? destination : pathD;  // path is destination without basename
+    auto       result            = FsResult{.isDirectory = isDirectory,
+                                            .path        = source,
+                                            .directory   = destinationPath,
+                                            .component   = nameAfterTransfer};
+
+    if (!parentD->isDirectory())
+    {
+        result.error = FsError::DestinationIsFile;
+        return result;
+    }
+
+    if (parentD->children().childAt(positionD, nameAfterTransfer))
+    {
+        if (ignoreIfAlreadyExist)
+        {
+            result.outcome = FsOutcome::Ignored;
+        }
+        else
+        {
+            result.error = FsError::AlreadyExists;
+        }
+        return result;
+    }
+    unshareChildren(*parentD, positionD, nameAfterTransfer);
+
+    if (transferMode == NodeTransferMode::Move)
+    {
+        if (parentS == parentD)
+        {
+            // The rename inside the directory doesn't change the aggregates, the node is only reordered
+            parentD->mutableChildren(*m_nodeStorage).rename(positionS, positionD, nameAfterTransfer);
+        }
+        else
+        {
+            // The name is the key of the node in the children, so it is changed only outside of the container.
+            // Only the moved node is relinked, its subtree keeps the links.
+            auto node = parentS->extractChild(*m_nodeStorage, positionS);
+            if (node->name != nameAfterTransfer)
+            {
+                node->name = nameAfterTransfer;
+            }
+            parentD->addChild(*m_nodeStorage, positionD, std::move(node));
+        }
+        recordMoved(*parentD, nameAfterTransfer, *parentS, basenameS);
+        // The paths of the moved subtree are changed
+        m_pathCache.invalidate();
+    }
+    else
+    {
+        // The copy shares the content with the source, the content is cloned on the first modification.
+        // The source is read by the position found before the destination: if the lookup of the destination
+        // has cloned the shared content of the source parent, the original content is kept by its other owners.
+        auto       newNode    = (*positionS)->copy(*m_nodeStorage, nameAfterTransfer);
+        const auto copiedNode = parentD->addChild(*m_nodeStorage, positionD, std::move(newNode));
+        recordCreated(*parentD, nameAfterTransfer);
+        if (copiedNode->isDirectory())
+        {
+            // The cached nodes of the source subtree are shared now, so they must be unshared before modification
+            m_pathCache.invalidate();
+        }
+    }
+    return result;
+}
+
+FsResult FsTree::transferMatching(const std::string_view pattern, const std::string_view destination,
+                                  const NodeTransferMode transferMode)
+{
+    auto destinationPath = parsePath(destination, m_destinationPathBuffer).normalizedPath;
+    if (destinationPath.size() > 1 && destinationPath.back() == pathDelimiter)
+    {
+        destinationPath.remove_suffix(1);
+    }
+
+    // The destination is found before the walk, so the walk doesn't see the unshared contents
+    auto       result          = FsResult{};
+    const auto destinationNode = findNodeByPath(destinationPath, result);
+    if (!destinationNode)
+    {
+        return result;
+    }
+
+    const auto normalizedPattern = parsePath(pattern, m_sourcePathBuffer).normalizedPath;
+    if (!destinationNode->isDirectory())
+    {
+        return makeError(FsError::DestinationNotADirectory, normalizedPattern, {}, destinationPath);
+    }
+
+    collectMatches(normalizedPattern);
+    if (m_matches.empty())
+    {
+        return makeError(FsError::NoMatches, normalizedPattern);
+    }
+    // The items, which are already in the destination, and the destination itself are left as they are
+    std::erase_if(m_matches, [destinationPath](const GlobMatch& match)
+                  { return match.path == destinationPath || parentPath(match.path) == destinationPath; });
+    if (m_matches.empty())
+    {
+        return FsResult{.outcome = FsOutcome::Unchanged, .path = normalizedPattern, .directory = destinationPath};
+    }
+
+    // All matches are validated before the first change, so the failed operation changes nothing
+    auto names         = std::unordered_set<std::string_view>{};
+    auto ignoredNumber = std::size_t{0};
+    for (auto& match : m_matches)
+    {
+        const auto name = itemName(match.path);
+        if (isSameOrInside(destinationPath, match.path))
+        {
+            return makeError(FsError::TransferIntoSubdirectory, match.path, {}, destinationPath);
+        }
+        countChildrenLookup(false);
+        if (destinationNode->children().contains(name) || !names.insert(name).second)
+        {
+            if (match.node->isDirectory())
+            {
+                result             = makeError(FsError::AlreadyExists, match.path, name, destinationPath);
+                result.isDirectory = true;
+                return result;
+            }
+            match.ignored = true;
+            ++ignoredNumber;
+        }
+    }
+
+    result = FsResult{.path          = normalizedPattern,
+                      .directory     = destinationPath,
+                      .matchesNumber = m_matches.size(),
+                      .ignoredNumber = ignoredNumber};
+
+    auto parent     = static_cast<FsNode*>(nullptr);
+    auto lastParent = std::string_view{};
+    for (const auto& match : m_matches)
+    {
+        if (match.ignored)
+        {
+            continue;
+        }
+        if (transferMode == NodeTransferMode::Copy)
+        {
+            // The copies share the contents with the sources, the contents are cloned on the first modification
+            destinationNode->addChild(*m_nodeStorage, match.node->copy(*m_nodeStorage, itemName(match.path)));
+            recordCreated(*destinationNode, itemName(match.path));
+            continue;
+        }
+
+        const auto matchParent = parentPath(match.path);
+        if (!parent || matchParent != lastParent)
+        {
+            parent     = findNodeByPath(matchParent, result);
+            lastParent = matchParent;
+            if (!parent)
+            {
+                return result;
+            }
+        }
+        destinationNode->addChild(*m_nodeStorage, parent->extractChild(*m_nodeStorage, itemName(match.path)));
+        recordMoved(*destinationNode, itemName(match.path), *parent, itemName(match.path));
+    }
+
+    // The paths of the moved subtrees are changed, the cached nodes of the copied subtrees are shared now
+    m_pathCache.invalidate();
+    return result;
+}
+
+void FsTree::unshareChildren(FsNode& directory, FsChildren::const_iterator& position, const std::string_view name)
+{
+    const auto  isShared = directory.directory.isShared();
+    const auto& children = directory.mutableChildren(*m_nodeStorage);
+    if (isShared)
+    {
+        // The position refers to the original content, the clone has the same children
+        countChildrenLookup(false);
+        position = children.lowerBound(name);
+    }
+}
+
+FsResult FsTree::validateAndCreateNode(const NodeType requiredNodeType, const std::string_view nodeAbsolutePath,
+                                       const bool ignoreIfAlreadyExist)
+{
+    const auto [normalizedNodePath, path, basename, nodeType] =
+      parsePath(nodeAbsolutePath, m_sourcePathBuffer, requiredNodeType);
+
+    if (requiredNodeType == NodeType::File && nodeType == NodeType::Invalid)
+    {
+        // File can have basename without '.'
+        // Directory can have basename with '.'
+        // Wrong is file "f.txt/" or "f/"
+        return makeError(FsError::InvalidFileReference, normalizedNodePath, basename);
+    }
+    if (basename.empty())
+    {
+        return makeError(FsError::EmptyBasename, normalizedNodePath);
+    }
+
+    auto       result = FsResult{};
+    const auto parent = findNodeByPath(path, result);
+    if (!parent)
+    {
+        return result;
+    }
+    if (!parent->isDirectory())
+    {
+        return makeError(FsError::NotADirectory, normalizedNodePath, parent->name);
+    }
+
+    result = FsResult{.isDirectory = requiredNodeType == NodeType::Directory,
+                      .path        = normalizedNodePath,
+                      .directory   = path,
+                      .component   = basename};
+
+    countChildrenLookup(false);
+    if (!parent->children().contains(basename))
+    {
+        parent->addChild(*m_nodeStorage, m_nodeStorage->createNode(basename, result.isDirectory));
+        recordCreated(*parent, basename);
+    }
+    else if (ignoreIfAlreadyExist)
+    {
+        result.outcome = FsOutcome::Ignored;
+    }
+    else
+    {
+        result.error = FsError::AlreadyExists;
+    }
+    return result;
+}
+
+FsResult FsTree::validateAndTransferNode(const std::string_view s, const std::string_view d,
+                                         const NodeTransferMode transferMode)
+{
+    const auto [source, pathS, basenameS, nodeTypeS]      = parsePath(s, m_sourcePathBuffer);
+    const auto [destination, pathD, basenameD, nodeTypeD] = parsePath(d, m_destinationPathBuffer);
+    const auto destinationIsRoot              = isRootDirectory(pathD, basenameD);
+    // mv d1/d2 /   - basenameD is empty, so we say that newBasenameD = basenameS
+    const auto newBasenameD                   = destinationIsRoot ? basenameS : basenameD;
+
+    if (isRootDirectory(pathS, basenameS))
+    {
+        return makeError(FsError::RootTransfer, source);
+    }
+    if (basenameS.empty() || newBasenameD.empty())
+    {
+        return makeError(FsError::EmptyBasename, basenameS.empty() ? source : destination);
+    }
+    if ((pathS == pathD && basenameS == basenameD) || (pathS == m_root->name && destinationIsRoot))
+    {
+        // Ignore moving item into itself.
+        return FsResult{.outcome = FsOutcome::Unchanged, .path = source, .directory = destination};
+    }
+
+    auto sourceWithoutSlash = std::string_view{source};
+    if (sourceWithoutSlash.back() == pathDelimiter)
+    {
+        sourceWithoutSlash.remove_suffix(1);
+    }
+    if (destination.starts_with(sourceWithoutSlash) && destination.length() > sourceWithoutSlash.length()
+        && destination.at(sourceWithoutSlash.length()) == pathDelimiter)
+    {
+        // Checks that, for example, /d1 is a subdirectory of /d1/d2 and not a subdirectory of /d11/d2
+        return makeError(FsError::TransferIntoSubdirectory, source, {}, destination);
+    }
+
+    // The source is modified only when it is moved, the copy shares the content of the source
+    auto       result  = FsResult{};
+    const auto parentS = findNodeByPath(pathS, result,
+                                        transferMode == NodeTransferMode::Move ? NodeAccess::Modify
+                                                                               : NodeAccess::ReadOnly);
+    if (!parentS)
+    {
+        return result;
+    }
+    if (transferMode == NodeTransferMode::Move && parentS->isDirectory())
+    {
+        // The moved node is extracted from the children, so they are unshared before the lookup. The destination
+        // lookup doesn't change them, so the position of the source stays valid until the transfer.
+        parentS->mutableChildren(*m_nodeStorage);
+    }
+    countChildrenLookup(false);
+    const auto positionS = parentS->children().lowerBound(basenameS);
+    const auto nodeS     = parentS->children().childAt(positionS, basenameS);
+    if (!nodeS)
+    {
+        result             = makeError(FsError::NoSuchItem, source);
+        result.isDirectory = nodeTypeS == NodeType::Directory;
+        return result;
+    }
+
+    // The parent of the moved node is found for modification, so the destination can be found starting from it
+    auto parentD = transferMode == NodeTransferMode::Move ? findNodeByPath(pathD, parentS, pathS, result)
+                                                          : findNodeByPath(pathD, result);
+    if (!parentD)
+    {
+        return result;
+    }
+    if (parentS == parentD && basenameS == newBasenameD)
+    {
+        return FsResult{.outcome = FsOutcome::Unchanged, .path = source, .directory = destination};
+    }
+    if (!parentD->isDirectory())
+    {
+        return makeError(FsError::DestinationNotADirectory, source, {}, pathD);
+    }
+
+    const auto sourceIsDir = nodeS->isDirectory();
+    if (!sourceIsDir && source.back() == pathDelimiter)
+    {
+        // Wrong basename of the source file.
+        return makeError(FsError::InvalidFileReference, source, basenameWithSlash(source, basenameS));
+    }
+
+    const auto ignoreIfAlreadyExist = sourceIsDir ? false : true;
+
+    countChildrenLookup(false);
+    auto positionD = parentD->children().lowerBound(newBasenameD);
+    if (parentD->children().childAt(positionD, newBasenameD) && !destinationIsRoot)
+    {
+        // For example, we have d3/d1. After we mv d3/d1 /  .
+        // This must move d1 from d3 into the root folder.
+        // If basenameD == newBasenameD -> the destination path is like /d1 - move d3/d1 into /d1
+        // If basenameD != newBasenameD -> the destination path is like / - move d3/d1 into /
+        // So, in case basenameD != newBasenameD we must prevent replacing of parent root with
+        // it child d1.
+        unshareChildren(*parentD, positionD, newBasenameD);
+        parentD = positionD->get();
+
+        // Move with the same name
+        countChildrenLookup(false);
+        return transferNode(sourceIsDir, parentS, positionS, parentD, parentD->children().lowerBound(basenameS),
+                            source, destination, basenameS, "", pathD, ignoreIfAlreadyExist, transferMode);
+    }
+
+    if (!sourceIsDir && destination.back() == pathDelimiter && !destinationIsRoot)
+    {
+        // Wrong basename of the destination file.
+        return makeError(FsError::InvalidFileReference, destination, basenameWithSlash(destination, basenameD));
+    }
+
+    // Move and rename
+    return transferNode(sourceIsDir, parentS, positionS, parentD, positionD, source, destination, basenameS,
+                        newBasenameD, pathD, ignoreIfAlreadyExist, transferMode);
+}
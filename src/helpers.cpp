@@ -2,9 +2,13 @@
 
 #include <algorithm>
 
+#include "byte_scanner.h"
+
 namespace
 {
 constexpr inline auto fileDelimiter = '.';
+constexpr inline auto anySequence   = '*';
+constexpr inline auto anyCharacter  = '?';
 
 }  // namespace
 
@@ -13,14 +17,57 @@ bool isFilename(const std::string_view filename)
     return filename.find_first_of(fileDelimiter) != std::string_view::npos;
 }
 
+bool isGlobPattern(const std::string_view str)
+{
+    return str.find_first_of("*?") != std::string_view::npos;
+}
+
+bool matchesGlob(const std::string_view pattern, const std::string_view name)
+{
+    // The greedy matching with the backtracking to the last '*': the characters after the '*' are matched
+    // again from the next position of the name, so the matching takes O(pattern * name) in the worst case.
+    auto patternPos = std::size_t{0}, namePos = std::size_t{0};
+    auto starPos = std::string_view::npos, starNamePos = std::size_t{0};
+
+    while (namePos < name.size())
+    {
+        if (patternPos < pattern.size() && pattern[patternPos] == anySequence)
+        {
+            starPos     = patternPos++;
+            starNamePos = namePos;
+        }
+        else if (patternPos < pattern.size()
+                 && (pattern[patternPos] == anyCharacter || pattern[patternPos] == name[namePos]))
+        {
+            ++patternPos;
+            ++namePos;
+        }
+        else if (starPos != std::string_view::npos)
+        {
+            patternPos = starPos + 1;
+            namePos    = ++starNamePos;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (patternPos < pattern.size() && pattern[patternPos] == anySequence)
+    {
+        ++patternPos;
+    }
+    return patternPos == pattern.size();
+}
+
 int isSpace(const unsigned char c)
 {
-    return std::isspace(c);
+    return isByteOf(c, ByteClass::Space) ? 1 : 0;
 }
 
 void trim(std::string& str)
 {
-    const auto first = std::find_if_not(str.begin(), str.end(), isSpace);
+    const auto first = str.begin() + static_cast<std::ptrdiff_t>(skipBytesOf(str, ByteClass::Space));
     const auto last  = std::find_if_not(str.rbegin(), str.rend(), isSpace).base();
 
     if (first < last)
@@ -32,3 +79,11 @@ void trim(std::string& str)
         str.clear();  // All spaces
     }
 }
+
+std::string_view trimmed(std::string_view str)
+{
+    const auto first = str.begin() + static_cast<std::ptrdiff_t>(skipBytesOf(str, ByteClass::Space));
+    const auto last  = std::find_if_not(str.rbegin(), str.rend(), isSpace).base();
+
+    return first < last ? std::string_view{first, last} : std::string_view{};
+}
@@ -5,6 +5,8 @@
 
 namespace
 {
+constexpr inline auto chunkedLogCapacity = std::size_t{64 * 1024};
+
 std::string makeLogString(const std::string_view logType, const std::string_view commandString,
                           const std::string_view message)
 {
@@ -25,23 +27,166 @@ std::string makeLogString(const std::string_view logType, const std::string_view
 }
 }  // namespace
 
+Logger::Logger(const LogLevel minLevel) : m_minLevel{minLevel}
+{
+}
+
+bool Logger::isEnabled(const LogLevel level) const noexcept
+{
+    return level >= m_minLevel && level != LogLevel::Off;
+}
+
+LogLevel Logger::minLevel() const noexcept
+{
+    return m_minLevel;
+}
+
+void Logger::setMinLevel(const LogLevel minLevel) noexcept
+{
+    m_minLevel = minLevel;
+}
+
+void Logger::setCollectStatistics(const bool collectStatistics) noexcept
+{
+    m_collectStatistics = collectStatistics;
+}
+
+const Logger::Statistics& Logger::statistics() const noexcept
+{
+    return m_statistics;
+}
+
+void Logger::flush()
+{
+    std::cout.flush();
+}
+
 bool Logger::logError(const std::string_view errorMessage, const std::string_view commandString)
 {
-    return writeLog(makeLogString("ERROR: ", commandString, errorMessage));
+    return writeMessage(LogLevel::Error, commandString, errorMessage);
 }
 
 bool Logger::logInfo(const std::string_view infoMessage, const std::string_view commandString)
 {
-    return writeLog(makeLogString("INFO: ", commandString, infoMessage));
+    return writeMessage(LogLevel::Info, commandString, infoMessage);
 }
 
 bool Logger::logWarning(const std::string_view warningMessage, const std::string_view commandString)
 {
-    return writeLog(makeLogString("WARNING: ", commandString, warningMessage));
+    return writeMessage(LogLevel::Warning, commandString, warningMessage);
+}
+
+Logger::ChunkedLog Logger::startChunkedInfo()
+{
+    return ChunkedLog{*this, levelPrefix(LogLevel::Info), isEnabled(LogLevel::Info)};
+}
+
+bool Logger::writeLine(const std::string_view line)
+{
+    const auto start   = m_collectStatistics ? metricsNow() : std::chrono::steady_clock::time_point{};
+    const auto written = writeLog(line);
+    countLog(line.size(), start);
+    return written;
+}
+
+bool Logger::finishLog()
+{
+    std::cout << '\n';
+    return static_cast<bool>(std::cout);
 }
 
 bool Logger::writeLog(const std::string_view log)
 {
-    std::cout << log << std::endl;
+    std::cout << log << '\n';
     return static_cast<bool>(std::cout);
 }
+
+bool Logger::writeLogChunk(const std::string_view chunk)
+{
+    std::cout << chunk;
+    return static_cast<bool>(std::cout);
+}
+
+bool Logger::writeMessage(const LogLevel level, const std::string_view commandString, const std::string_view message)
+{
+    if (!isEnabled(level))
+    {
+        return true;
+    }
+
+    const auto start   = m_collectStatistics ? metricsNow() : std::chrono::steady_clock::time_point{};
+    const auto log     = makeLogString(levelPrefix(level), commandString, message);
+    const auto written = writeLog(log);
+    countLog(log.size(), start);
+    return written;
+}
+
+std::string_view Logger::levelPrefix(const LogLevel level) noexcept
+{
+    switch (level)
+    {
+        case LogLevel::Error:
+            return "ERROR: ";
+        case LogLevel::Info:
+            return "INFO: ";
+        case LogLevel::Warning:
+            return "WARNING: ";
+        default:
+            return "";
+    }
+}
+
+Logger::ChunkedLog::ChunkedLog(Logger& logger, const std::string_view logType, const bool enabled) :
+    m_logger{logger}, m_enabled{enabled}
+{
+    if (m_enabled)
+    {
+        m_start = m_logger.m_collectStatistics ? metricsNow() : std::chrono::steady_clock::time_point{};
+        m_buffer.reserve(chunkedLogCapacity);
+        m_buffer.append(logType);
+    }
+}
+
+Logger::ChunkedLog::~ChunkedLog()
+{
+    if (m_enabled)
+    {
+        flushBuffer();
+        m_logger.finishLog();
+        m_logger.countLog(m_bytesLogged, m_start);  // The time includes producing of the text of the message
+    }
+}
+
+Logger::ChunkedLog& Logger::ChunkedLog::append(std::string_view text)
+{
+    if (!m_enabled)
+    {
+        return *this;
+    }
+
+    while (m_buffer.size() + text.size() > chunkedLogCapacity)
+    {
+        const auto part = text.substr(0, chunkedLogCapacity - m_buffer.size());
+        m_buffer.append(part);
+        text.remove_prefix(part.size());
+        flushBuffer();
+    }
+
+    m_buffer.append(text);
+    return *this;
+}
+
+bool Logger::ChunkedLog::good() const noexcept
+{
+    return m_good;
+}
+
+void Logger::ChunkedLog::flushBuffer()
+{
+    if (!m_buffer.empty())
+    {
+        m_good = m_logger.writeLogChunk(m_buffer) && m_good;
+        m_bytesLogged += m_buffer.size();
+        m_buffer.clear();
+    }
+}
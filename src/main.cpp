@@ -1,15 +1,367 @@
+#include <algorithm>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <format>
 #include <iostream>
+#include <optional>
+#include <string_view>
+#include <thread>
 
+#include "async_logger.h"
 #include "file_manager_emulator.h"
+#include "fme_metrics.h"
 #include "logger.h"
+#include "session_server.h"
+
+namespace
+{
+/**
+ * \brief Options of the command line: [--log-level=info|warning|error|off] [--async-log] [--pipeline]
+ * [--fast-exit] [--path-cache-size=N] [--path-cache-stats] [--metrics] [--memory-report] [--load-snapshot=PATH]
+ * [--save-snapshot=PATH] [--journal=PATH] [--checkpoint-interval=N] [--resume] [--serve=SOCKET] [--workers=N] [--tree-output=full|changes]
+ * [--transactional] [--result-lines] [batch_file].
+ */
+struct Options
+{
+        std::string_view           batchFileName;
+        LogLevel                   logLevel = LogLevel::Info;
+        bool                       asyncLog = false;
+        bool                       pipeline = false;
+        bool                       fastExit = false;
+        std::optional<std::size_t> pathCacheSize;
+        bool                       pathCacheStats = false;
+        bool                       metrics        = false;
+        bool                       memoryReport   = false;
+        std::string_view           loadSnapshotPath;
+        std::string_view           saveSnapshotPath;
+        std::string_view           journalPath;
+        std::size_t                checkpointInterval = 100000;
+        bool                       resume             = false;
+        std::string_view           socketPath;
+        std::size_t                workersNumber = std::max(std::thread::hardware_concurrency(), 1u);
+        TreeOutput                 treeOutput    = TreeOutput::Full;
+        bool                       transactional = false;
+        bool                       resultLines   = false;
+};
+
+constexpr inline auto usage =
+  " [--log-level=info|warning|error|off] [--async-log] [--pipeline] [--fast-exit] [--path-cache-size=N]"
+  " [--path-cache-stats] [--metrics] [--memory-report] [--load-snapshot=PATH] [--save-snapshot=PATH]"
+  " [--journal=PATH] [--checkpoint-interval=N] [--resume] [--serve=SOCKET] [--workers=N]"
+  " [--tree-output=full|changes] [--transactional] [--result-lines] [batch_file]";
+
+// The running server is stopped by SIGINT and SIGTERM
+SessionServer* activeServer = nullptr;
+
+extern "C" void stopServer(int)
+{
+    if (activeServer)
+    {
+        activeServer->stop();
+    }
+}
+
+std::optional<LogLevel> parseLogLevel(const std::string_view level)
+{
+    if (level == "info")
+    {
+        return LogLevel::Info;
+    }
+    if (level == "warning")
+    {
+        return LogLevel::Warning;
+    }
+    if (level == "error")
+    {
+        return LogLevel::Error;
+    }
+    if (level == "off")
+    {
+        return LogLevel::Off;
+    }
+    return std::nullopt;
+}
+
+std::optional<TreeOutput> parseTreeOutput(const std::string_view treeOutput)
+{
+    if (treeOutput == "full")
+    {
+        return TreeOutput::Full;
+    }
+    if (treeOutput == "changes")
+    {
+        return TreeOutput::Changes;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::size_t> parseNumber(const std::string_view value)
+{
+    auto       number       = std::size_t{0};
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (value.empty() || error != std::errc{} || end != value.data() + value.size())
+    {
+        return std::nullopt;
+    }
+    return number;
+}
+
+std::optional<Options> parseOptions(const int argc, char** argv)
+{
+    constexpr auto logLevelOption      = std::string_view{"--log-level="};
+    constexpr auto pathCacheSizeOption = std::string_view{"--path-cache-size="};
+    constexpr auto loadSnapshotOption  = std::string_view{"--load-snapshot="};
+    constexpr auto saveSnapshotOption  = std::string_view{"--save-snapshot="};
+    constexpr auto journalOption       = std::string_view{"--journal="};
+    constexpr auto checkpointOption    = std::string_view{"--checkpoint-interval="};
+    constexpr auto serveOption         = std::string_view{"--serve="};
+    constexpr auto workersOption       = std::string_view{"--workers="};
+    constexpr auto treeOutputOption    = std::string_view{"--tree-output="};
+    auto           options             = Options{};
+    auto           logLevelSet         = false;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const auto arg = std::string_view{argv[i]};
+
+        if (arg.starts_with(logLevelOption))
+        {
+            const auto level = parseLogLevel(arg.substr(logLevelOption.size()));
+            if (!level)
+            {
+                std::cerr << "Unknown log level: " << arg << std::endl;
+                return std::nullopt;
+            }
+            options.logLevel = *level;
+            logLevelSet      = true;
+        }
+        else if (arg.starts_with(pathCacheSizeOption))
+        {
+            options.pathCacheSize = parseNumber(arg.substr(pathCacheSizeOption.size()));
+            if (!options.pathCacheSize)
+            {
+                std::cerr << "Invalid path cache size: " << arg << std::endl;
+                return std::nullopt;
+            }
+        }
+        else if (arg.starts_with(checkpointOption))
+        {
+            const auto interval = parseNumber(arg.substr(checkpointOption.size()));
+            if (!interval)
+            {
+                std::cerr << "Invalid checkpoint interval: " << arg << std::endl;
+                return std::nullopt;
+            }
+            options.checkpointInterval = *interval;
+        }
+        else if (arg.starts_with(workersOption))
+        {
+            const auto workers = parseNumber(arg.substr(workersOption.size()));
+            if (!workers || *workers == 0)
+            {
+                std::cerr << "Invalid number of workers: " << arg << std::endl;
+                return std::nullopt;
+            }
+            options.workersNumber = *workers;
+        }
+        else if (arg.starts_with(treeOutputOption))
+        {
+            const auto treeOutput = parseTreeOutput(arg.substr(treeOutputOption.size()));
+            if (!treeOutput)
+            {
+                std::cerr << "Unknown tree output: " << arg << std::endl;
+                return std::nullopt;
+            }
+            options.treeOutput = *treeOutput;
+        }
+        else if (arg.starts_with(serveOption))
+        {
+            options.socketPath = arg.substr(serveOption.size());
+        }
+        else if (arg.starts_with(journalOption))
+        {
+            options.journalPath = arg.substr(journalOption.size());
+        }
+        else if (arg.starts_with(loadSnapshotOption))
+        {
+            options.loadSnapshotPath = arg.substr(loadSnapshotOption.size());
+        }
+        else if (arg.starts_with(saveSnapshotOption))
+        {
+            options.saveSnapshotPath = arg.substr(saveSnapshotOption.size());
+        }
+        else if (arg == "--async-log")
+        {
+            options.asyncLog = true;
+        }
+        else if (arg == "--pipeline")
+        {
+            options.pipeline = true;
+        }
+        else if (arg == "--fast-exit")
+        {
+            options.fastExit = true;
+        }
+        else if (arg == "--path-cache-stats")
+        {
+            options.pathCacheStats = true;
+        }
+        else if (arg == "--metrics")
+        {
+            options.metrics = true;
+        }
+        else if (arg == "--memory-report")
+        {
+            options.memoryReport = true;
+        }
+        else if (arg == "--resume")
+        {
+            options.resume = true;
+        }
+        else if (arg == "--transactional")
+        {
+            options.transactional = true;
+        }
+        else if (arg == "--result-lines")
+        {
+            options.resultLines = true;
+        }
+        else if (options.batchFileName.empty())
+        {
+            options.batchFileName = arg;
+        }
+        else
+        {
+            std::cerr << "Unexpected argument: " << arg << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    if (options.resultLines && !logLevelSet)
+    {
+        // The result lines replace the log
+        options.logLevel = LogLevel::Off;
+    }
+    if (options.resume && options.journalPath.empty())
+    {
+        std::cerr << "--resume requires --journal" << std::endl;
+        return std::nullopt;
+    }
+    if (!options.socketPath.empty()
+        && (!options.batchFileName.empty() || !options.journalPath.empty() || !options.saveSnapshotPath.empty()))
+    {
+        std::cerr << "The server reads the batches from the socket, it doesn't support the batch file, "
+                     "the journal and saving of the snapshot"
+                  << std::endl;
+        return std::nullopt;
+    }
+
+    return options;
+}
+
+int serve(const Options& options)
+{
+    auto server = SessionServer{SessionServer::Settings{.socketPath       = std::string{options.socketPath},
+                                                        .workersNumber    = options.workersNumber,
+                                                        .logLevel         = options.logLevel,
+                                                        .pipeline         = options.pipeline,
+                                                        .pathCacheSize    = options.pathCacheSize,
+                                                        .baseSnapshotPath = std::string{options.loadSnapshotPath}}};
+
+    activeServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+
+    std::cout << "Serving the sessions on " << options.socketPath << " with " << options.workersNumber
+              << " workers..." << std::endl;
+    const auto served = server.run();
+    activeServer      = nullptr;
+
+    if (!served)
+    {
+        std::cerr << "Cannot serve on " << options.socketPath << ": " << std::strerror(errno) << std::endl;
+        return static_cast<int>(ErrorCode::CannotOpenDataStream);
+    }
+    return static_cast<int>(ErrorCode::NoError);
+}
+
+}  // namespace
 
 int main(int argc, char** argv)
 {
+    // The log is flushed explicitly, so the standard streams don't need to be synchronized with C stdio
+    std::ios::sync_with_stdio(false);
     std::cout << "File Manager Emulator is started!\n" << std::endl;
 
-    const auto batchFileName = argc > 1 ? argv[1] : "";
+    const auto options = parseOptions(argc, argv);
+    if (!options)
+    {
+        std::cerr << "Usage: " << argv[0] << usage << std::endl;
+        return static_cast<int>(ErrorCode::CommandArgumentsError);
+    }
+
+    if (!options->socketPath.empty())
+    {
+        return serve(*options);
+    }
+
+    auto logger = options->asyncLog
+                  ? std::unique_ptr<Logger>{std::make_unique<AsyncLogger>(std::cout, options->logLevel)}
+                  : std::make_unique<Logger>(options->logLevel);
+    auto fme    = FileManagerEmulator{std::move(logger)};
+
+    fme.setFastExit(options->fastExit);
+    fme.setPipelined(options->pipeline);
+    fme.setMetricsEnabled(options->metrics);
+    fme.setTreeOutput(options->treeOutput);
+    fme.setTransactional(options->transactional);
+    fme.setResultLines(options->resultLines);
+    if (options->pathCacheSize)
+    {
+        fme.setPathCacheCapacity(*options->pathCacheSize);
+    }
+
+    if (!options->loadSnapshotPath.empty() && !fme.loadSnapshot(options->loadSnapshotPath))
+    {
+        return static_cast<int>(ErrorCode::CannotOpenDataStream);
+    }
+    if (!options->journalPath.empty()
+        && !fme.openJournal(options->journalPath, options->checkpointInterval, options->resume))
+    {
+        return static_cast<int>(ErrorCode::JournalError);
+    }
+
+    auto result = fme.run(options->batchFileName);
+
+    if (result == ErrorCode::NoError && !options->saveSnapshotPath.empty()
+        && !fme.saveSnapshot(options->saveSnapshotPath))
+    {
+        result = ErrorCode::CannotOpenDataStream;
+    }
 
-    auto fme = FileManagerEmulator{std::make_unique<Logger>()};
+    if (options->pathCacheStats)
+    {
+        const auto& stats = fme.pathCacheStatistics();
+        std::cerr << "Path cache: capacity " << stats.capacity << ", hits " << stats.hits << ", misses "
+                  << stats.misses << ", insertions " << stats.insertions << ", invalidations " << stats.invalidations
+                  << std::endl;
+    }
+    if (options->metrics)
+    {
+        writeMetricsReport(fme.metrics(), std::cerr);
+    }
+    if (options->memoryReport)
+    {
+        const auto usage = fme.memoryUsage();
+        std::cerr << std::format("Memory: {} nodes of {} bytes, {} directory contents of {} bytes, children containers "
+                                 "{} bytes, {} long names {} bytes\n",
+                                 usage.nodes, sizeof(FsNode), usage.directories, sizeof(FsDirectory),
+                                 usage.childrenBytes, usage.longNames, usage.nameBytes)
+                  << std::format("Memory: total {} bytes, {:.1f} bytes per node\n", usage.totalBytes(),
+                                 static_cast<double>(usage.totalBytes()) / static_cast<double>(usage.nodes))
+                  << std::flush;
+    }
 
-    return static_cast<int>(fme.run(batchFileName));
+    return static_cast<int>(result);
 }
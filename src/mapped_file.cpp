@@ -0,0 +1,108 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define FME_HAS_MMAP 1
+#endif
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+std::string_view MappedFile::data() const noexcept
+{
+    return m_data ? std::string_view{static_cast<const char*>(m_data), m_size} : std::string_view{};
+}
+
+bool MappedFile::isOpen() const noexcept
+{
+    return m_isOpen;
+}
+
+#ifdef FME_HAS_MMAP
+
+bool MappedFile::open(const std::string_view path)
+{
+    unmap();
+
+    const auto  pathStr  = std::string{path};
+    struct stat pathStat = {};
+    if (::stat(pathStr.c_str(), &pathStat) == 0 && !S_ISREG(pathStat.st_mode))
+    {
+        // Opening of a named pipe would block the reader or break the writer, so such files aren't opened at all
+        errno = ENODEV;
+        return false;
+    }
+
+    const auto fd = ::open(pathStr.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat = {};
+    if (::fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+    {
+        // Only regular files have the stable size, which can be mapped
+        const auto error = S_ISREG(fileStat.st_mode) ? errno : ENODEV;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+
+    if (fileStat.st_size > 0)
+    {
+        const auto size = static_cast<std::size_t>(fileStat.st_size);
+        const auto data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            const auto error = errno;
+            ::close(fd);
+            errno = error;
+            return false;
+        }
+
+        // The file is read once from the beginning to the end
+        ::madvise(data, size, MADV_SEQUENTIAL);
+        m_data = data;
+        m_size = size;
+    }
+
+    // The mapping stays valid after closing of the file descriptor
+    ::close(fd);
+    m_isOpen = true;
+    return true;
+}
+
+void MappedFile::unmap() noexcept
+{
+    if (m_data)
+    {
+        ::munmap(m_data, m_size);
+    }
+
+    m_data   = nullptr;
+    m_size   = 0;
+    m_isOpen = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string_view)
+{
+    errno = ENOSYS;
+    return false;
+}
+
+void MappedFile::unmap() noexcept
+{
+}
+
+#endif  // FME_HAS_MMAP
@@ -0,0 +1,61 @@
+#include "path_cache.h"
+
+#include <bit>
+#include <functional>
+
+PathCache::PathCache(const std::size_t capacity)
+{
+    resize(capacity);
+}
+
+FsNode* PathCache::find(const std::string_view path)
+{
+    const auto entry = slot(path);
+    if (entry && entry->generation == m_generation && entry->path == path)
+    {
+        ++m_statistics.hits;
+        return entry->node;
+    }
+
+    ++m_statistics.misses;
+    return nullptr;
+}
+
+void PathCache::insert(const std::string_view path, FsNode* const node)
+{
+    if (const auto entry = slot(path))
+    {
+        // The string keeps its capacity, so replacing of entries rarely allocates memory
+        entry->path.assign(path);
+        entry->node       = node;
+        entry->generation = m_generation;
+        ++m_statistics.insertions;
+    }
+}
+
+void PathCache::invalidate() noexcept
+{
+    ++m_generation;
+    ++m_statistics.invalidations;
+}
+
+void PathCache::resize(const std::size_t capacity)
+{
+    m_entries.clear();
+    m_entries.resize(capacity == 0 ? 0 : std::bit_ceil(capacity));
+    m_statistics.capacity = m_entries.size();
+}
+
+const PathCache::Statistics& PathCache::statistics() const noexcept
+{
+    return m_statistics;
+}
+
+PathCache::Entry* PathCache::slot(const std::string_view path) noexcept
+{
+    if (m_entries.empty())
+    {
+        return nullptr;
+    }
+    return &m_entries[std::hash<std::string_view>{}(path) & (m_entries.size() - 1)];
+}
@@ -0,0 +1,302 @@
+#include "session_server.h"
+
+#include <cerrno>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "file_manager_emulator.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <sys/socket.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#    define FME_HAS_SOCKETS 1
+#endif
+
+namespace
+{
+constexpr inline auto listenBacklog = 128;
+constexpr inline auto readSize      = std::size_t{64 * 1024};
+
+/**
+ * \brief Logger, which collects the messages of one session into the string.
+ */
+class SessionLogger final : public Logger
+{
+    public:
+        SessionLogger(std::string& output, const LogLevel minLevel) : Logger{minLevel}, m_output{output} {}
+
+        void flush() override {}
+
+    protected:
+        bool finishLog() override
+        {
+            m_output.push_back('\n');
+            return true;
+        }
+
+        bool writeLog(const std::string_view log) override
+        {
+            m_output.append(log).push_back('\n');
+            return true;
+        }
+
+        bool writeLogChunk(const std::string_view chunk) override
+        {
+            m_output.append(chunk);
+            return true;
+        }
+
+    private:
+        std::string& m_output;
+};
+
+}  // namespace
+
+/**
+ * \brief Worker is the emulator of one worker thread with the base tree of its sessions.
+ */
+class SessionServer::Worker final
+{
+    public:
+        explicit Worker(const Settings& settings) :
+            m_settings{settings}, m_emulator{std::make_unique<SessionLogger>(m_output, settings.logLevel)}
+        {
+            m_emulator.setPipelined(settings.pipeline);
+            if (settings.pathCacheSize)
+            {
+                m_emulator.setPathCacheCapacity(*settings.pathCacheSize);
+            }
+        }
+        Worker(const Worker&) = delete;
+        Worker(Worker&&)      = delete;
+
+        ~Worker()
+        {
+            // The base is freed by the tree without recursion
+            if (m_base)
+            {
+                m_emulator.tree().replaceRoot(std::move(m_base));
+            }
+        }
+
+        Worker& operator=(const Worker&) = delete;
+        Worker& operator=(Worker&&)      = delete;
+
+        std::string runSession(const std::string_view commands)
+        {
+            m_output.clear();
+            auto& tree = m_emulator.tree();
+            if (m_base)
+            {
+                // The tree of the previous session is freed in slices between the commands
+                tree.replaceRoot(m_base->copy(tree.storage()));
+            }
+            else if (m_settings.baseSnapshotPath.empty() || m_emulator.loadSnapshot(m_settings.baseSnapshotPath))
+            {
+                // The base is loaded once, the sessions change only the copies of its root
+                m_base = tree.root().copy(tree.storage());
+                m_output.clear();
+            }
+            else
+            {
+                return finishSession(ErrorCode::CannotOpenDataStream);
+            }
+            return finishSession(m_emulator.runCommands(commands));
+        }
+
+    private:
+        std::string finishSession(const ErrorCode result)
+        {
+            std::format_to(std::back_inserter(m_output), "RESULT: {}\n", static_cast<int>(result));
+            return m_output;
+        }
+
+    private:
+        const Settings&     m_settings;
+        std::string         m_output;  // The log of the current session
+        FileManagerEmulator m_emulator;
+        FsNodePtr           m_base;  // The copy of the root of the base tree, it shares all contents
+};
+
+SessionServer::SessionServer(Settings settings) : m_settings{std::move(settings)}
+{
+    if (m_settings.workersNumber == 0)
+    {
+        m_settings.workersNumber = 1;
+    }
+}
+
+void SessionServer::serveConnections()
+{
+    auto worker = Worker{m_settings};
+    while (true)
+    {
+        auto connection = -1;
+        {
+            auto lock = std::unique_lock{m_mutex};
+            m_connectionsAvailable.wait(lock, [this]() { return m_closed || !m_connections.empty(); });
+            if (m_connections.empty())
+            {
+                return;  // Closed and all accepted connections are served
+            }
+            connection = m_connections.front();
+            m_connections.pop_front();
+        }
+        serveConnection(connection, worker);
+    }
+}
+
+#ifdef FME_HAS_SOCKETS
+
+bool SessionServer::run()
+{
+    auto address = sockaddr_un{};
+    if (m_settings.socketPath.empty() || m_settings.socketPath.size() >= sizeof(address.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    m_settings.socketPath.copy(address.sun_path, m_settings.socketPath.size());
+
+    const auto listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        return false;
+    }
+
+    // The socket file of the previous server is replaced
+    ::unlink(m_settings.socketPath.c_str());
+    if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listener, listenBacklog) != 0)
+    {
+        const auto error = errno;
+        ::close(listener);
+        errno = error;
+        return false;
+    }
+
+    m_listener.store(listener);
+    if (m_stopped.load())
+    {
+        ::shutdown(listener, SHUT_RDWR);  // stop() was called before the listener was published
+    }
+
+    auto workers = std::vector<std::thread>{};
+    workers.reserve(m_settings.workersNumber);
+    for (auto i = std::size_t{0}; i < m_settings.workersNumber; ++i)
+    {
+        workers.emplace_back(&SessionServer::serveConnections, this);
+    }
+
+    while (!m_stopped.load())
+    {
+        const auto connection = ::accept(listener, nullptr, nullptr);
+        if (connection < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            break;  // The listener is shut down by stop() or failed
+        }
+
+        {
+            auto lock = std::lock_guard{m_mutex};
+            m_connections.push_back(connection);
+        }
+        m_connectionsAvailable.notify_one();
+    }
+
+    {
+        auto lock = std::lock_guard{m_mutex};
+        m_closed  = true;
+    }
+    m_connectionsAvailable.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    m_listener.store(-1);
+    ::close(listener);
+    ::unlink(m_settings.socketPath.c_str());
+    return true;
+}
+
+void SessionServer::stop() noexcept
+{
+    m_stopped.store(true);
+    if (const auto listener = m_listener.load(); listener >= 0)
+    {
+        // Wakes up accept(), the descriptor is closed by run()
+        ::shutdown(listener, SHUT_RDWR);
+    }
+}
+
+void SessionServer::serveConnection(const int connection, Worker& worker) const
+{
+    auto commands = std::string{};
+    while (true)
+    {
+        const auto size = commands.size();
+        commands.resize(size + readSize);
+        const auto received = ::read(connection, commands.data() + size, readSize);
+        if (received < 0 && errno == EINTR)
+        {
+            commands.resize(size);
+            continue;
+        }
+        commands.resize(size + static_cast<std::size_t>(received > 0 ? received : 0));
+        if (received <= 0)
+        {
+            break;  // The client has finished the batch (or the connection is broken)
+        }
+    }
+
+    const auto output = worker.runSession(commands);
+
+    // The client can leave without reading the output, so the broken connection doesn't raise SIGPIPE
+#    ifdef MSG_NOSIGNAL
+    constexpr auto sendFlags = MSG_NOSIGNAL;
+#    else
+    constexpr auto sendFlags = 0;
+#    endif
+    for (auto sent = std::size_t{0}; sent < output.size();)
+    {
+        const auto written = ::send(connection, output.data() + sent, output.size() - sent, sendFlags);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            break;
+        }
+        sent += static_cast<std::size_t>(written);
+    }
+    ::close(connection);
+}
+
+#else
+
+bool SessionServer::run()
+{
+    errno = ENOSYS;
+    return false;
+}
+
+void SessionServer::stop() noexcept
+{
+    m_stopped.store(true);
+}
+
+void SessionServer::serveConnection(int, Worker&) const {}
+
+#endif
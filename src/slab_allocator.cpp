@@ -0,0 +1,80 @@
+#include "slab_allocator.h"
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+namespace
+{
+constexpr inline auto initialBlocksPerSlab = std::size_t{64};
+constexpr inline auto maxBlocksPerSlab     = std::size_t{64 * 1024};
+
+std::size_t alignUp(const std::size_t value, const std::size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+SlabAllocator::SlabAllocator(const std::size_t blockSize, const std::size_t blockAlignment) :
+    m_blockSize{alignUp(std::max(blockSize, sizeof(FreeBlock)), std::max(blockAlignment, alignof(FreeBlock)))},
+    m_blocksPerSlab{initialBlocksPerSlab}
+{
+    if (blockAlignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        throw std::invalid_argument("SlabAllocator doesn't support over-aligned blocks.");
+    }
+    m_statistics.blockSize = m_blockSize;
+}
+
+void* SlabAllocator::allocate()
+{
+    if (!m_freeList)
+    {
+        allocateSlab();
+    }
+
+    auto block = m_freeList;
+    m_freeList = block->next;
+
+    ++m_statistics.totalAllocations;
+    ++m_statistics.blocksInUse;
+    m_statistics.peakBlocksInUse = std::max(m_statistics.peakBlocksInUse, m_statistics.blocksInUse);
+
+    return block;
+}
+
+void SlabAllocator::deallocate(void* const block) noexcept
+{
+    if (!block)
+    {
+        return;
+    }
+
+    m_freeList = ::new (block) FreeBlock{.next = m_freeList};
+
+    ++m_statistics.totalDeallocations;
+    --m_statistics.blocksInUse;
+}
+
+const SlabAllocator::Statistics& SlabAllocator::statistics() const noexcept
+{
+    return m_statistics;
+}
+
+void SlabAllocator::allocateSlab()
+{
+    const auto slabSize = m_blockSize * m_blocksPerSlab;
+    auto       slab     = std::make_unique_for_overwrite<std::byte[]>(slabSize);
+
+    // Link blocks of the new slab into the free list in the order of addresses
+    for (auto i = m_blocksPerSlab; i > 0; --i)
+    {
+        m_freeList = ::new (slab.get() + (i - 1) * m_blockSize) FreeBlock{.next = m_freeList};
+    }
+
+    m_slabs.push_back(std::move(slab));
+    ++m_statistics.slabsNumber;
+    m_statistics.bytesReserved += slabSize;
+    m_blocksPerSlab             = std::min(m_blocksPerSlab * 2, maxBlocksPerSlab);
+}